@@ -14,6 +14,7 @@
 #include <optional>
 #include <map>
 #include <vector>
+#include <functional>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include "mysqlx/xdevapi.h"
@@ -176,18 +177,60 @@ int test_read_appProp() {
  * Repository をインタフェースとして、ProxyRepo と SubjectRepo がある。
 */
 
+/**
+ * MySQLXStatements クラス
+ *
+ * 1 つのセッション（Repository）の Table と、where を :名前 のプレースホルダで書いた文（TableSelect 等）を保持する。
+ * 同じ文オブジェクトを bind の値だけ変えて再実行すると、コネクタはサーバ側で prepare した文を再利用する。
+ * 文のテキストがキーごとに変わらないので、2 回目以降は解析、実行計画の作成を省ける。
+ * 文は name（DATA の中で一意な名前）で区別し、最初の 1 回だけ make で作る。
+*/
+
+class MySQLXStatements final {
+public:
+    explicit MySQLXStatements(mysqlx::Table* _table): table(_table)
+    {}
+    mysqlx::Table& getTable() const { return *table; }
+    mysqlx::TableSelect& select(const std::string& name, const std::function<mysqlx::TableSelect(mysqlx::Table&)>& make) {
+        return get(selects, name, make);
+    }
+    mysqlx::TableUpdate& update(const std::string& name, const std::function<mysqlx::TableUpdate(mysqlx::Table&)>& make) {
+        return get(updates, name, make);
+    }
+    mysqlx::TableRemove& remove(const std::string& name, const std::function<mysqlx::TableRemove(mysqlx::Table&)>& make) {
+        return get(removes, name, make);
+    }
+private:
+    template <class S>
+    S& get(std::map<std::string, S>& stmts, const std::string& name, const std::function<S(mysqlx::Table&)>& make) {
+        auto it = stmts.find(name);
+        if(it == stmts.end()) {
+            it = stmts.emplace(name, make(*table)).first;
+        }
+        return it->second;
+    }
+    mysqlx::Table*                              table;
+    std::map<std::string, mysqlx::TableSelect>  selects;
+    std::map<std::string, mysqlx::TableUpdate>  updates;
+    std::map<std::string, mysqlx::TableRemove>  removes;
+};
+
 template <class DATA, class PKEY>
 class MySQLXData {
 public:
     virtual ~MySQLXData() = default;
-    virtual DATA insertQuery(mysqlx::Session*)  const = 0;
-    virtual DATA findOneQuery(mysqlx::Session*, const PKEY&) const = 0;
-    virtual DATA updateQuery(mysqlx::Session*)  const = 0;
-    virtual void removeQuery(mysqlx::Session*, const PKEY&)  const = 0;
+    // stmts は Repository が保持するもの（Table は SCHEMA_NAME、TABLE_NAME）、クエリ自身は Schema、Table、文を毎回作らない
+    virtual DATA insertQuery(MySQLXStatements&)  const = 0;
+    virtual DATA findOneQuery(MySQLXStatements&, const PKEY&) const = 0;
+    virtual DATA updateQuery(MySQLXStatements&)  const = 0;
+    virtual void removeQuery(MySQLXStatements&, const PKEY&)  const = 0;
 };
 
 class PersonData final : public MySQLXData<PersonData, std::size_t> {
 public:
+    static constexpr const char* SCHEMA_NAME = "cheshire";
+    static constexpr const char* TABLE_NAME  = "person";
+
     PersonData(const std::size_t& _id
             , const std::string& _name
             , const std::string& _email
@@ -204,12 +247,10 @@ public:
     PersonData(const std::string& _name
             , const std::string& _email ): id(0ul), name(_name), email(_email), age(std::nullopt)
     {}
-    virtual PersonData insertQuery(mysqlx::Session* sess) const override
+    virtual PersonData insertQuery(MySQLXStatements& stmts) const override
     {
         puts("------ PersonData::insertQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        mysqlx::TableInsert tblIns = person.insert("name", "email", "age");
+        mysqlx::TableInsert tblIns = stmts.getTable().insert("name", "email", "age");
         mysqlx::Result res;
         if(age.has_value()) {
             res = tblIns.values(name, email, age.value()).execute();
@@ -222,15 +263,15 @@ public:
         }
         return result;
     }
-    virtual PersonData findOneQuery(mysqlx::Session* sess, const std::size_t& pkey) const override
+    virtual PersonData findOneQuery(MySQLXStatements& stmts, const std::size_t& pkey) const override
     {
         puts("------ PersonData::findOneQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(pkey));
-
-        mysqlx::RowResult rowRes = person.select("name", "email" , "age").where(cond).execute();
+        mysqlx::TableSelect& select = stmts.select("findOne", [](mysqlx::Table& person) {
+            mysqlx::TableSelect stmt = person.select("name", "email" , "age");
+            stmt.where("id = :id");
+            return stmt;
+        });
+        mysqlx::RowResult rowRes = select.bind("id", pkey).execute();
         std::string r_name;
         std::string r_email;
         std::optional<int> r_age = std::nullopt;
@@ -248,20 +289,26 @@ public:
             return PersonData(pkey, r_name, r_email);
         }
     }
-    virtual PersonData updateQuery(mysqlx::Session* sess) const override
+    virtual PersonData updateQuery(MySQLXStatements& stmts) const override
     {
         puts("------ PersonData::updateQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(id));
-
+        // 値もプレースホルダにして、文のテキストを固定する。age が無い場合は age を変更しない別の文
         if(age.has_value()) {
-            person.update().set("name", name).set("email", email).set("age", age.value())
-                    .where(cond).execute();
+            mysqlx::TableUpdate& update = stmts.update("update", [](mysqlx::Table& person) {
+                mysqlx::TableUpdate stmt = person.update();
+                stmt.set("name", mysqlx::expr(":name")).set("email", mysqlx::expr(":email")).set("age", mysqlx::expr(":age"))
+                    .where("id = :id");
+                return stmt;
+            });
+            update.bind("name", name).bind("email", email).bind("age", age.value()).bind("id", id).execute();
         } else {
-            person.update().set("name", name).set("email", email)
-                    .where(cond).execute();
+            mysqlx::TableUpdate& update = stmts.update("updateNoAge", [](mysqlx::Table& person) {
+                mysqlx::TableUpdate stmt = person.update();
+                stmt.set("name", mysqlx::expr(":name")).set("email", mysqlx::expr(":email"))
+                    .where("id = :id");
+                return stmt;
+            });
+            update.bind("name", name).bind("email", email).bind("id", id).execute();
         }
 
         PersonData result(id, name, email);
@@ -270,14 +317,14 @@ public:
         }
         return result;
     }
-    virtual void removeQuery(mysqlx::Session* sess, const std::size_t& pkey)  const override
+    virtual void removeQuery(MySQLXStatements& stmts, const std::size_t& pkey)  const override
     {
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(pkey));
-
-        person.remove().where(cond).execute();
+        mysqlx::TableRemove& remove = stmts.remove("remove", [](mysqlx::Table& person) {
+            mysqlx::TableRemove stmt = person.remove();
+            stmt.where("id = :id");
+            return stmt;
+        });
+        remove.bind("id", pkey).execute();
     }
 
 
@@ -310,31 +357,34 @@ public:
 template<class DATA, class PKEY>
 class MySQLXBasicRepository final : public Repository<DATA, PKEY> {
 public:
+    /**
+     * Table と文はリポジトリ（= 1 つのセッション）ごとに最初の 1 回だけ作り、以降の CRUD で再利用する。
+    */
     MySQLXBasicRepository(mysqlx::Session* _session, const DATA& _data): session(_session), d(_data)
     {}
     virtual DATA insert(const DATA& data)  const
     {
         puts("------ MySQLXBasicRepository::insert()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&data);
-        return pdata->insertQuery(session);
+        return pdata->insertQuery(statements());
     }
     virtual DATA update(const DATA& data)  const
     {
         puts("------ MySQLXBasicRepository::update()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&data);
-        return pdata->updateQuery(session);
+        return pdata->updateQuery(statements());
     }
     virtual DATA findOne(const PKEY& pkey) const
     {
         puts("------ MySQLXBasicRepository::findOne()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&d);
-        return pdata->findOneQuery(session, pkey);
+        return pdata->findOneQuery(statements(), pkey);
     }
     virtual void remove(const PKEY& pkey) const
     {
         puts("------ MySQLXBasicRepository::remove()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&d);
-        return pdata->removeQuery(session, pkey);
+        return pdata->removeQuery(statements(), pkey);
     }
     /**
      * 単なるテンプレート型に過ぎない DATA をどのようにインスタンス化するのか。
@@ -354,8 +404,18 @@ public:
     */
 
 private:
-    mysqlx::Session* session;
-    DATA d;
+    MySQLXStatements& statements() const
+    {
+        if(!stmts.has_value()) {
+            tbl.emplace(session->getSchema(DATA::SCHEMA_NAME).getTable(DATA::TABLE_NAME));
+            stmts.emplace(&tbl.value());
+        }
+        return stmts.value();
+    }
+    mysqlx::Session*                            session;
+    DATA                                        d;
+    mutable std::optional<mysqlx::Table>        tbl;
+    mutable std::optional<MySQLXStatements>     stmts;     // 文はリポジトリ（= 1 つのセッション）ごとに再利用する
 };
 
 int test_MySQLXBasicRepository_insert(std::size_t* pkey) {
@@ -414,6 +474,28 @@ int test_MySQLXBasicRepository_findOne(std::size_t* pkey) {
     }
 }
 
+int test_MySQLXBasicRepository_findOne_repeat(std::size_t* pkey) {
+    puts("=== test_MySQLXBasicRepository_findOne_repeat");
+    try {
+        PersonData alice(*pkey, "", "");
+        mysqlx::Session sess(appProp.myx.uri, appProp.myx.port, appProp.myx.user, appProp.myx.password);
+        MySQLXBasicRepository<PersonData, std::size_t> basicRepo(&sess, alice);
+        // 同じリポジトリの 2 回目以降は、bind の値だけを変えて同じ文を再実行する（サーバ側で prepare 済みの文を使う）
+        PersonData first = basicRepo.findOne(*pkey);
+        for(int i = 0; i < 3; i++) {
+            PersonData ret = basicRepo.findOne(*pkey);
+            assert(ret.getName()  == first.getName());
+            assert(ret.getEmail() == first.getEmail());
+        }
+        PersonData none = basicRepo.findOne(0);
+        assert(none.getName().empty());
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 int test_MySQLXBasicRepository_remove(std::size_t* pkey) {
     puts("=== test_MySQLXBasicRepository_remove");
     try {
@@ -540,6 +622,8 @@ int main(void)
         assert(ret == 0);
         ptr_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXBasicRepository_findOne(pkey));
         assert(ret == 0);
+        ptr_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXBasicRepository_findOne_repeat(pkey));
+        assert(ret == 0);
         ptr_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXBasicRepository_remove(pkey));
         assert(ret == 0);
     }
@@ -0,0 +1,178 @@
+#ifndef BULKLOAD_H_
+#define BULKLOAD_H_
+
+#include <array>
+#include <tuple>
+#include <chrono>
+#include <string>
+#include <ranges>
+#include <cerrno>
+#include <cstring>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "Debug.hpp"
+#include "MySQLConnection.hpp"
+
+/**
+ * BulkLoadReport 構造体
+ *
+ * 一括ロードの結果、移行作業で進捗と速度を確認するためのもの。
+*/
+
+struct BulkLoadReport {
+    std::size_t              rows    = 0;
+    std::size_t              batches = 0;
+    std::chrono::nanoseconds elapsed{0};
+
+    double rowsPerSec() const {
+        const double sec = std::chrono::duration<double>(elapsed).count();
+        return sec > 0 ? rows / sec : 0.0;
+    }
+};
+
+/**
+ * BulkDescriptor 構造体
+ *
+ * 一括ロードするテーブルとカラム、カラムごとに DATA から値を取り出す関数（getter）を宣言順に持つ。
+ * getter の戻り値は文字列、整数、浮動小数点数、あるいはそれらの std::optional（std::nullopt は NULL）。
+ *
+ * e.g.
+ * auto desc = makeBulkDescriptor<PersonData>("person", {"name", "email", "age"}
+ *     , [](const PersonData& d) { return d.getName().getValue(); }
+ *     , ...);
+*/
+
+template <class DATA, class... Getters>
+struct BulkDescriptor {
+    std::string                                      table;
+    std::array<std::string_view, sizeof...(Getters)> columns;
+    std::tuple<Getters...>                           getters;
+};
+
+template <class DATA, class... Getters>
+BulkDescriptor<DATA, Getters...> makeBulkDescriptor(std::string table
+    , const std::array<std::string_view, sizeof...(Getters)>& columns
+    , Getters... getters)
+{
+    return BulkDescriptor<DATA, Getters...>{std::move(table), columns, std::tuple<Getters...>(std::move(getters)...)};
+}
+
+namespace bulk {
+
+/**
+ * LOAD DATA の既定の書式（FIELDS TERMINATED BY '\t' ESCAPED BY '\\' LINES TERMINATED BY '\n'）で値を 1 つ書く。
+ * NULL は \N、区切り文字と \ はエスケープする。
+*/
+template <class T>
+void appendField(std::string& out, const T& v) {
+    if constexpr (requires { v.has_value(); *v; }) {
+        if(!v.has_value()) {
+            out.append("\\N");
+        } else {
+            appendField(out, *v);
+        }
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        for(char c: std::string_view(v)) {
+            switch(c) {
+            case '\t': out.append("\\t");  break;
+            case '\n': out.append("\\n");  break;
+            case '\r': out.append("\\r");  break;
+            case '\\': out.append("\\\\"); break;
+            case '\0': out.append("\\0");  break;
+            default:   out.push_back(c);
+            }
+        }
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        char buf[32];
+        auto [p, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, ec == std::errc() ? p - buf : 0);
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "unsupported bulk column type.");
+    }
+}
+
+template <class DATA, class... Getters>
+void appendRow(std::string& out, const BulkDescriptor<DATA, Getters...>& desc, const DATA& data) {
+    std::apply([&](const auto&... get) {
+        std::size_t i = 0;
+        ((out.append(i++ ? "\t" : ""), appendField(out, get(data))), ...);
+    }, desc.getters);
+    out.push_back('\n');
+}
+
+}   // namespace bulk
+
+/**
+ * MySQL の一括ロード、LOAD DATA LOCAL INFILE を使う。
+ *
+ * chunkRows 行ずつ TSV に書式化して memfd（メモリ上のファイル）に書き、/proc/self/fd/N を LOCAL INFILE として渡す。
+ * 行ごとの往復、SQL の解析が無くなり、サーバ側に残るのは制約の検査だけになる。
+ *
+ * 前提：サーバの local_infile=ON、コネクションの OPT_LOCAL_INFILE=1（driver->connect の ConnectOptionsMap で指定）。
+ * LOCAL の場合、重複キー等で拒否された行はエラーではなく警告になる（IGNORE と同じ）ので、
+ * 書き込まれた行数が送った行数と異なる場合は例外とする。トランザクションは呼び出し側で管理すること。
+*/
+
+template <std::ranges::input_range R, class DATA, class... Getters>
+BulkLoadReport mysqlLoadData(const MySQLConnection* con
+    , const BulkDescriptor<DATA, Getters...>& desc
+    , R&& rows
+    , const std::size_t& chunkRows = 100000)
+{
+    logger::trace("------ mysqlLoadData table is ", desc.table);
+    const auto start = std::chrono::steady_clock::now();
+    const int fd = memfd_create("orm_bulk_load", MFD_CLOEXEC);
+    if(fd < 0) {
+        throw std::runtime_error(std::string("memfd_create: ") + std::strerror(errno));
+    }
+    struct FdCloser {       // 例外の経路でも閉じる、例外は型（sql::SQLException 等）を保ったまま伝える
+        int fd;
+        ~FdCloser() {
+            close(fd);
+        }
+    } closer{fd};
+    BulkLoadReport report;
+    std::string sql("LOAD DATA LOCAL INFILE '/proc/self/fd/");
+    sql.append(std::to_string(fd)).append("' INTO TABLE ").append(desc.table)
+       .append(" CHARACTER SET utf8mb4 FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n' (");
+    for(std::size_t i = 0; i < desc.columns.size(); i++) {
+        sql.append(i ? ", " : "").append(desc.columns[i]);
+    }
+    sql.append(")");
+    logger::debug("sql: ", sql);
+    std::unique_ptr<sql::Statement> stmt(con->createStatement());
+    std::string buf;
+    std::size_t pending = 0;
+    auto flush = [&] {
+        if(ftruncate(fd, 0) != 0 || pwrite(fd, buf.data(), buf.size(), 0) != static_cast<ssize_t>(buf.size())) {
+            throw std::runtime_error(std::string("memfd write: ") + std::strerror(errno));
+        }
+        const int loaded = stmt->executeUpdate(sql);
+        if(loaded < 0 || static_cast<std::size_t>(loaded) != pending) {
+            throw std::runtime_error("LOAD DATA rejected " + std::to_string(pending - std::max(loaded, 0)) + " rows.");
+        }
+        report.rows += pending;
+        report.batches++;
+        buf.clear();
+        pending = 0;
+    };
+    const std::size_t limit = std::max<std::size_t>(1, chunkRows);
+    for(const DATA& data: rows) {
+        bulk::appendRow(buf, desc, data);
+        if(++pending == limit) {
+            flush();
+        }
+    }
+    if(pending > 0) {
+        flush();
+    }
+    report.elapsed = std::chrono::steady_clock::now() - start;
+    return report;
+}
+
+#endif
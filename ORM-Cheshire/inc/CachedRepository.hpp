@@ -0,0 +1,390 @@
+#ifndef CACHEDREPOSITORY_H_
+#define CACHEDREPOSITORY_H_
+
+#include <span>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "Debug.hpp"
+#include "Repository.hpp"
+
+/**
+ * CacheStats 構造体
+ *
+ * RepositoryCache の計数のスナップショット。
+*/
+
+struct CacheStats {
+    std::size_t hits      = 0;      // キャッシュから応えた
+    std::size_t misses    = 0;      // inner に問い合わせた
+    std::size_t coalesced = 0;      // 同じキーの問い合わせ中だったので、その結果を待った（single-flight）
+    std::size_t evictions = 0;      // 容量超過で追い出した
+    std::size_t expired   = 0;      // TTL 切れで捨てた
+};
+
+/**
+ * RepositoryCache クラス
+ *
+ * 変更の少ない、よく読まれるデータの findOne 結果の共有キャッシュ（サイズ上限つき LRU、TTL）。
+ * キーのハッシュでシャードに分け、シャードごとの mutex で保護する（スレッド間で共有してよい）。
+ *
+ * コネクション（Repository）はスレッド間で共有できないので、キャッシュ本体と Repository は分けている。
+ * スレッド（コネクション）ごとに CachedRepository を作り、同じ RepositoryCache を渡すこと。
+ * 同じキーの取得が複数スレッドで同時に起きた場合、問い合わせるのは最初の 1 つだけで、他はその結果を待つ（single-flight）。
+*/
+
+template <class DATA, class PKEY>
+class RepositoryCache final {
+public:
+    RepositoryCache(const std::size_t& _capacity
+        , const std::chrono::milliseconds& _ttl
+        , const std::size_t& _shards = 0)
+    : nshards(_shards ? _shards : std::max(1u, std::thread::hardware_concurrency()))
+    , shardCapacity(std::max<std::size_t>(1, _capacity / nshards))
+    , ttl(_ttl)
+    , shards(std::make_unique<Shard[]>(nshards))
+    {}
+    RepositoryCache(const RepositoryCache&)            = delete;
+    RepositoryCache& operator=(const RepositoryCache&) = delete;
+
+    /**
+     * キャッシュにあればそれを、無ければ load（inner->findOne）の結果を返す。
+     * 見つからなかった（std::nullopt）結果はキャッシュしない。
+    */
+    std::optional<DATA> getOrLoad(const PKEY& pkey, const std::function<std::optional<DATA>()>& load) {
+        Shard& s = shardOf(pkey);
+        std::shared_ptr<Flight> flight;
+        std::shared_future<std::optional<DATA>> waiting;
+        {
+            std::lock_guard<std::mutex> guard(s.m);
+            if(std::optional<DATA> hit = lookup(s, pkey)) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return hit;
+            }
+            auto fit = s.inflight.find(pkey);
+            if(fit != s.inflight.end()) {
+                waiting = fit->second->result;
+            } else {
+                flight = std::make_shared<Flight>();
+                flight->result = flight->promise.get_future().share();
+                s.inflight.emplace(pkey, flight);
+            }
+        }
+        if(!flight) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            return waiting.get();
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        try {
+            std::optional<DATA> data = load();
+            {
+                std::lock_guard<std::mutex> guard(s.m);
+                if(data.has_value() && !flight->stale) {      // 取得中に invalidate されたものは入れない
+                    store(s, pkey, data.value());
+                }
+                s.inflight.erase(pkey);
+            }
+            flight->promise.set_value(data);
+            return data;
+        } catch(...) {
+            {
+                std::lock_guard<std::mutex> guard(s.m);
+                s.inflight.erase(pkey);
+            }
+            flight->promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+    std::optional<DATA> get(const PKEY& pkey) {
+        Shard& s = shardOf(pkey);
+        std::lock_guard<std::mutex> guard(s.m);
+        std::optional<DATA> hit = lookup(s, pkey);
+        (hit ? hits : misses).fetch_add(1, std::memory_order_relaxed);
+        return hit;
+    }
+    void put(const PKEY& pkey, const DATA& data) {
+        Shard& s = shardOf(pkey);
+        std::lock_guard<std::mutex> guard(s.m);
+        markStale(s, pkey);
+        store(s, pkey, data);
+    }
+    void invalidate(const PKEY& pkey) {
+        Shard& s = shardOf(pkey);
+        std::lock_guard<std::mutex> guard(s.m);
+        markStale(s, pkey);
+        auto it = s.index.find(pkey);
+        if(it != s.index.end()) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+        }
+    }
+    void clear() {
+        for(std::size_t i = 0; i < nshards; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].m);
+            for(auto& [k, f]: shards[i].inflight) {
+                f->stale = true;
+            }
+            shards[i].lru.clear();
+            shards[i].index.clear();
+        }
+    }
+    std::size_t size() const {
+        std::size_t n = 0;
+        for(std::size_t i = 0; i < nshards; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].m);
+            n += shards[i].index.size();
+        }
+        return n;
+    }
+    CacheStats stats() const {
+        CacheStats st;
+        st.hits      = hits.load();
+        st.misses    = misses.load();
+        st.coalesced = coalesced.load();
+        st.evictions = evictions.load();
+        st.expired   = expired.load();
+        return st;
+    }
+private:
+    struct Entry {
+        PKEY                                    key;
+        DATA                                    data;
+        std::chrono::steady_clock::time_point   expires;
+    };
+    struct Flight {
+        std::promise<std::optional<DATA>>       promise;
+        std::shared_future<std::optional<DATA>> result;
+        bool                                    stale = false;      // シャードの mutex で保護する
+    };
+    /**
+     * シャード、先頭が最も新しい。false sharing を避けるためキャッシュライン境界に揃える。
+    */
+    struct alignas(64) Shard {
+        mutable std::mutex                                                  m;
+        std::list<Entry>                                                    lru;
+        std::unordered_map<PKEY, typename std::list<Entry>::iterator>       index;
+        std::unordered_map<PKEY, std::shared_ptr<Flight>>                   inflight;
+    };
+    Shard& shardOf(const PKEY& pkey) const {
+        return shards[std::hash<PKEY>{}(pkey) % nshards];
+    }
+    // s.m を取得した状態で呼ぶこと
+    std::optional<DATA> lookup(Shard& s, const PKEY& pkey) {
+        auto it = s.index.find(pkey);
+        if(it == s.index.end()) {
+            return std::nullopt;
+        }
+        if(it->second->expires <= std::chrono::steady_clock::now()) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+            expired.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return it->second->data;
+    }
+    void store(Shard& s, const PKEY& pkey, const DATA& data) {
+        auto it = s.index.find(pkey);
+        if(it != s.index.end()) {
+            s.lru.erase(it->second);        // DATA が代入不可でもよいように、作り直す
+            s.index.erase(it);
+        }
+        if(s.index.size() >= shardCapacity) {       // 追い出してから入れる
+            s.index.erase(s.lru.back().key);
+            s.lru.pop_back();
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        s.lru.push_front(Entry{pkey, data, std::chrono::steady_clock::now() + ttl});
+        s.index.emplace(pkey, s.lru.begin());
+    }
+    void markStale(Shard& s, const PKEY& pkey) {
+        auto fit = s.inflight.find(pkey);
+        if(fit != s.inflight.end()) {
+            fit->second->stale = true;
+        }
+    }
+
+    const std::size_t                   nshards;
+    const std::size_t                   shardCapacity;
+    const std::chrono::milliseconds     ttl;
+    std::unique_ptr<Shard[]>            shards;
+    std::atomic<std::size_t>            hits{0};
+    std::atomic<std::size_t>            misses{0};
+    std::atomic<std::size_t>            coalesced{0};
+    std::atomic<std::size_t>            evictions{0};
+    std::atomic<std::size_t>            expired{0};
+};
+
+/**
+ * CachedRepository クラス
+ *
+ * RepositoryCache を前に置いた Repository のデコレータ（読み通し）。同じインタフェースなので、
+ * 具象の Repository に手を入れずに MySQLReadStrategy 等へそのまま渡せる。
+ *
+ * - findOne はキャッシュ、無ければ inner->findOne（single-flight）。findByIds はキャッシュに無いものだけを問い合わせる。
+ *   findByIds で取得したものはキャッシュに入れない（single-flight を通らないので、取得中の invalidate を検出できない）。
+ * - insert、update、upsert、remove はキャッシュを破棄するだけで、書き込んだ結果を入れることはしない。
+ *   RepositoryCache は他のスレッドと共有しているので、rollback されるかもしれない（commit 前の）データを見せてはいけない。
+ * - 書き込んだキーは覚えておき、afterTx() で再度破棄する。書き込みから commit までの間に他のスレッドが
+ *   commit 済みの古い行を読み込み、キャッシュに入れている可能性があるため。
+ *   それまでの間、そのキーの findOne、findByIds はキャッシュを通さずに inner に問い合わせる（自分の commit 前の行を入れない）。
+ * - findAll、insertMany はキャッシュの対象外。
+ *
+ * CachedRepository はコネクションと同じく 1 つのスレッドで使うこと（書き込んだキーの記録はロックで保護していない）。
+ * auto commit で使う場合は、書き込みの戻りで commit 済みなので afterTx() を呼ばなくても古い行は残らない。
+ *
+ * e.g.
+ * static RepositoryCache<PersonData, std::size_t> personCache(10000, std::chrono::seconds(30));
+ * PersonRepository repo(&mcon);
+ * CachedRepository<PersonData, std::size_t> cached(&repo, &personCache, [](const PersonData& d) { return d.getId().getValue(); });
+ * MySQLUpdateStrategy<PersonData, std::size_t> strategy(&cached, data);
+ * MySQLTx<PersonData> tx(&mcon, &strategy);
+ * tx.executeTx();          // 例外（rollback）の場合も afterTx() を呼ぶこと
+ * cached.afterTx();
+*/
+
+template <class DATA, class PKEY>
+class CachedRepository final : public Repository<DATA, PKEY> {
+public:
+    using KeyOf = std::function<PKEY(const DATA&)>;
+
+    CachedRepository(const Repository<DATA, PKEY>* _inner, RepositoryCache<DATA, PKEY>* _cache, KeyOf _keyOf)
+    : inner(_inner), cache(_cache), keyOf(std::move(_keyOf))
+    {}
+    virtual std::optional<DATA> insert(const DATA& data) const override {
+        std::optional<DATA> result = inner->insert(data);
+        if(result.has_value()) {
+            written(keyOf(result.value()));     // 同じトランザクションの findOne で commit 前の行を入れないため
+        }
+        return result;
+    }
+    virtual std::optional<DATA> update(const DATA& data) const override {
+        const PKEY pkey = keyOf(data);
+        written(pkey);
+        try {
+            std::optional<DATA> result = inner->update(data);
+            cache->invalidate(pkey);        // update 中に他のスレッドが読み込んだものも捨てる
+            return result;
+        } catch(...) {
+            cache->invalidate(pkey);        // 書き込まれたかどうかわからない
+            throw;
+        }
+    }
+    virtual void remove(const PKEY& pkey) const override {
+        written(pkey);
+        inner->remove(pkey);
+        cache->invalidate(pkey);            // remove 中に他のスレッドが読み込んだものも捨てる
+    }
+    virtual std::optional<DATA> findOne(const PKEY& pkey) const override {
+        if(pending.contains(pkey)) {
+            return inner->findOne(pkey);    // commit 前の行はキャッシュに入れない
+        }
+        return cache->getOrLoad(pkey, [this, &pkey] { return inner->findOne(pkey); });
+    }
+    virtual std::vector<PKEY> insertMany(std::span<const DATA> datas, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        return inner->insertMany(datas, chunkSize);
+    }
+    /**
+     * upsert も破棄のみ。UNIQUE の重複で別のキーの行が更新された場合、その行はキャッシュから外せない（TTL で消える）。
+    */
+    virtual std::optional<DATA> upsert(const DATA& data) const override {
+        const PKEY pkey = keyOf(data);
+        written(pkey);
+        try {
+            std::optional<DATA> result = inner->upsert(data);
+            cache->invalidate(pkey);
+            if(result.has_value()) {
+                written(keyOf(result.value()));
+            }
+            return result;
+        } catch(...) {
+            cache->invalidate(pkey);        // 書き込まれたかどうかわからない
+            throw;
+        }
+    }
+    virtual void upsertMany(std::span<const DATA> datas, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        for(const DATA& d: datas) {
+            written(keyOf(d));
+        }
+        try {
+            inner->upsertMany(datas, chunkSize);
+        } catch(...) {
+            invalidateAll(datas);
+            throw;
+        }
+        invalidateAll(datas);
+    }
+    virtual FindResult<DATA, PKEY> findByIds(std::span<const PKEY> pkeys, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        std::unordered_map<PKEY, std::optional<DATA>> known;
+        std::vector<PKEY> unknown;
+        for(const PKEY& k: pkeys) {
+            if(known.find(k) != known.end()) {
+                continue;
+            }
+            std::optional<DATA> hit = pending.contains(k) ? std::nullopt : cache->get(k);
+            if(!hit.has_value()) {
+                unknown.push_back(k);
+            }
+            known.emplace(k, std::move(hit));
+        }
+        if(!unknown.empty()) {
+            FindResult<DATA, PKEY> fetched = inner->findByIds(std::span<const PKEY>(unknown), chunkSize);
+            for(std::size_t i = 0; i < unknown.size(); i++) {
+                known.erase(unknown[i]);
+                known.emplace(unknown[i], std::move(fetched.rows[i]));
+            }
+        }
+        FindResult<DATA, PKEY> result;
+        result.rows.reserve(pkeys.size());
+        std::unordered_set<PKEY> reported;
+        for(const PKEY& k: pkeys) {
+            const std::optional<DATA>& row = known.at(k);
+            result.rows.push_back(row);
+            if(!row.has_value() && reported.insert(k).second) {
+                result.missing.push_back(k);
+            }
+        }
+        return result;
+    }
+    virtual Cursor<DATA> findAll(const std::size_t& fetchSize = Repository<DATA, PKEY>::DEFAULT_FETCH_SIZE) const override {
+        return inner->findAll(fetchSize);
+    }
+    /**
+     * トランザクションの終了（commit、rollback のどちらでも）の後に呼ぶ。
+     * 書き込んだキーを再度破棄し、以降はキャッシュを通常通り使う。
+    */
+    void afterTx() const {
+        for(const PKEY& k: pending) {
+            cache->invalidate(k);
+        }
+        pending.clear();
+    }
+private:
+    /**
+     * 書き込む前に記録して破棄する、以降 afterTx() までそのキーはキャッシュを通さない。
+    */
+    void written(const PKEY& pkey) const {
+        pending.insert(pkey);
+        cache->invalidate(pkey);
+    }
+    void invalidateAll(std::span<const DATA> datas) const {
+        for(const DATA& d: datas) {
+            cache->invalidate(keyOf(d));
+        }
+    }
+    const Repository<DATA, PKEY>*       inner;
+    RepositoryCache<DATA, PKEY>*        cache;
+    KeyOf                               keyOf;
+    mutable std::unordered_set<PKEY>    pending;        // 書き込んだ、commit を確認していないキー
+};
+
+#endif
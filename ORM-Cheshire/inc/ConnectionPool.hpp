@@ -1,50 +1,432 @@
 #ifndef CONNECTIONPOOL_H_
 #define CONNECTIONPOOL_H_
 
-#include <queue>
+#include <deque>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include "Debug.hpp"
 #include "Exception.hpp"
+#include "PoolStats.hpp"
 
 template <class T>
 class ConnectionPool final {
 public:
-    ConnectionPool() : credit(std::move("none."))
+    /**
+     * Lease クラス
+     *
+     * borrow() で貸し出したオブジェクトをスコープの終了時に自動で Pool に返却する（RAII）。
+     * コピーは禁止、ムーブのみ可能。例外が発生した経路でも返却漏れが起きない。
+    */
+    class Lease final {
+    public:
+        Lease(): pool(nullptr), pt(nullptr)
+        {}
+        Lease(const ConnectionPool<T>* _pool, T* _pt): pool(_pool), pt(_pt), since(std::chrono::steady_clock::now())
+        {}
+        ~Lease() {
+            release();
+        }
+        Lease(const Lease&)            = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& own) noexcept: pool(own.pool), pt(own.pt), since(own.since) {
+            own.pool = nullptr;
+            own.pt   = nullptr;
+        }
+        Lease& operator=(Lease&& own) noexcept {
+            if(this != &own) {
+                release();
+                pool     = own.pool;
+                pt       = own.pt;
+                since    = own.since;
+                own.pool = nullptr;
+                own.pt   = nullptr;
+            }
+            return *this;
+        }
+        T* get() const {
+            return pt;
+        }
+        T* operator->() const {
+            return pt;
+        }
+        T& operator*() const {
+            return *pt;
+        }
+        explicit operator bool() const {
+            return pt != nullptr;
+        }
+        /**
+         * 明示的に Pool へ返却する、以降このリースは空になる。
+        */
+        void release() {
+            if(pool && pt) {
+                pool->recorder.recordHold(std::chrono::steady_clock::now() - since);
+                pool->giveBack(pt);
+            }
+            pool = nullptr;
+            pt   = nullptr;
+        }
+        /**
+         * 壊れていると判断したオブジェクトを Pool に戻さずに破棄する、以降このリースは空になる。
+         * 貸し出し中の数から外すので、保守スレッドの refill が代わりを補充できる。
+        */
+        void discard() {
+            if(pool && pt) {
+                pool->recorder.recordHold(std::chrono::steady_clock::now() - since);
+                pool->destroyBorrowed(pt);
+            }
+            pool = nullptr;
+            pt   = nullptr;
+        }
+    private:
+        const ConnectionPool<T>* pool;
+        T* pt;
+        std::chrono::steady_clock::time_point since;       // 貸し出した時刻、保持時間の計測に使う
+    };
+
+    ConnectionPool() : ConnectionPool(std::string("none."), 1)
+    {}
+    ConnectionPool(const std::string& _credit) : ConnectionPool(_credit, 1)
     {}
-    ConnectionPool(const std::string& _credit) : credit(std::move(_credit))
+    /**
+     * シャード（サブキュー）数を指定するコンストラクタ。
+     * 1 の場合は従来通り 1 つのキューと 1 つの mutex で動作する。
+     * 0 を指定した場合は CPU（ハードウェアスレッド）数分のシャードを用意する。
+     *
+     * 各スレッドは自分のホームシャードに push、pop し、ホームが空であれば隣のシャードから奪う（stealing）。
+     * 48 スレッドのような負荷で 1 つの mutex に競合が集中することを避けるためのもの。
+    */
+    ConnectionPool(const std::string& _credit, const std::size_t& _shards)
+    : credit(_credit)
+    , nshards(_shards ? _shards : std::max(1u, std::thread::hardware_concurrency()))
+    , shards(std::make_unique<Shard[]>(nshards))
     {}
     ~ConnectionPool() {     // その役割が任意のポインタの Pool なので、解放は本クラスで行う必要がある。
-        while(!q.empty()) {
-            const T* pt = q.front();
-            q.pop();
-            delete pt;
+        stopMaintenance();
+        for(std::size_t i = 0; i < nshards; i++) {
+            while(!shards[i].q.empty()) {
+                const T* pt = shards[i].q.front();
+                shards[i].q.pop_front();
+                notifyEvict(pt);
+                delete pt;
+            }
         }
         std::string message(R"(...... Done ConnectionPool Destructor credit is )");
         message.append(credit);
         puts(message.c_str());
     }
     bool empty() {
-        return q.empty();
+        return available.load() == 0;
     }
+    /**
+     * 新しいオブジェクトを Pool に投入する、貸し出し中の数には触れない。
+     * pop() で借りたものを返す場合は giveBack() を使うこと。
+    */
     void push(T* pt) const {
-        std::lock_guard<std::mutex> guard(m);
-        q.push(pt);
+        pushIdle(pt);
+    }
+    /**
+     * pop() で借りたオブジェクトを返却する、貸し出し中の数を 1 減らす。
+     * 待機中を増やしてから減らすので、保守スレッドから見た合計が一時的に減ることはない（過剰な補充を防ぐ）。
+    */
+    void giveBack(T* pt) const {
+        pushIdle(pt);
+        borrowed.fetch_sub(1);
     }
     T* pop() const {
-        std::lock_guard<std::mutex> guard(m);
-        T* ret = nullptr;
-        if(!q.empty()) {
-            ret = q.front();
-            q.pop();
-        }
+        T* ret = tryPop();
         if(!ret) {
+            recorder.recordExhaustion();
             throw std::runtime_error(NoPoolException().what()) ;
         }
+        recorder.recordBorrow(std::chrono::steady_clock::duration::zero());
         return ret;     // TODO nullptr の場合は、何らかの exception としたいが、やりすぎかな。
     }
+    /**
+     * Pool が空の場合は timeout まで返却を待つ pop。
+     * バースト時に即座に失敗させず、数ミリ秒待てば戻ってくるコネクションを利用するためのもの。
+     * timeout までに取得できなければ NoPoolException と同じメッセージで例外を投げる。
+    */
+    T* pop(const std::chrono::milliseconds& timeout) const {
+        T* ret = tryPop();
+        if(ret) {
+            recorder.recordBorrow(std::chrono::steady_clock::duration::zero());     // 待ちがなければ時計も読まない
+            return ret;
+        }
+        recorder.recordExhaustion();
+        const auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(wm);
+        waiters.fetch_add(1);
+        cv.wait_for(lock, timeout, [this, &ret]{ return (ret = tryPop()) != nullptr; });
+        waiters.fetch_sub(1);
+        if(!ret) {
+            recorder.recordTimeout();
+            throw std::runtime_error(NoPoolException().what());
+        }
+        recorder.recordBorrow(std::chrono::steady_clock::now() - start);
+        return ret;
+    }
+    /**
+     * pop(timeout) の RAII 版、返却は Lease のデストラクタが行う。
+     * giveBack() を呼び出し側で書く必要はない。
+    */
+    Lease borrow(const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0)) const {
+        return Lease(this, pop(timeout));
+    }
+    std::size_t shardCount() const {
+        return nshards;
+    }
+    /**
+     * 保守スレッドを開始する。
+     *
+     * interval ごとに、待機中（貸し出していない）オブジェクトを 1 つずつ取り出して ping で生存確認を行い、
+     * 死んでいるものは破棄する。その後、貸し出し中と待機中の合計が target に満たなければ factory で補充する。
+     * 死んだコネクションのコストを利用者のリクエストではなく、保守スレッドに払わせるためのもの。
+     *
+     * ping、factory は保守スレッドから呼ばれる。factory が例外を投げた、あるいは nullptr を返した場合は
+     * その周期の補充を諦め、次の周期で再試行する。
+    */
+    void startMaintenance(std::function<bool(T*)> _ping
+                        , std::function<T*()> _factory
+                        , const std::size_t& _target
+                        , const std::chrono::milliseconds& _interval) const
+    {
+        stopMaintenance();
+        std::lock_guard<std::mutex> guard(mm);
+        stopping = false;
+        maintainer = std::thread([this, _ping, _factory, _target, _interval]{
+            std::unique_lock<std::mutex> lock(mm);
+            while(!mcv.wait_for(lock, _interval, [this]{ return stopping; })) {
+                lock.unlock();
+                maintain(_ping, _factory, _target);
+                lock.lock();
+            }
+        });
+    }
+    void stopMaintenance() const {
+        {
+            std::lock_guard<std::mutex> guard(mm);
+            stopping = true;
+        }
+        mcv.notify_all();
+        if(maintainer.joinable()) {
+            maintainer.join();
+        }
+    }
+    /**
+     * Pool がオブジェクトを破棄する（保守スレッドの evict、デストラクタ）直前に呼ぶ関数を登録する。
+     * コネクションに紐づくキャッシュ（e.g. ormx::MySQLXHandleCache）を捨てるためのもの。
+     * 保守スレッドから呼ばれることがあるので、hook はスレッドセーフであること。
+    */
+    void onEvict(std::function<void(const T*)> hook) const {
+        std::lock_guard<std::mutex> guard(hm);
+        evictHook = std::move(hook);
+    }
+    std::size_t borrowedCount() const {
+        return borrowed.load();
+    }
+    std::size_t evictedCount() const {
+        return evicted.load();
+    }
+    /**
+     * 統計のスナップショット、集計は呼び出した時点で行う。
+     * 保持時間は Lease で返却されたものだけが対象（pop() と giveBack() を直接使った場合は計測できない）。
+    */
+    PoolStats stats() const {
+        PoolStats st = recorder.snapshot();
+        st.borrowCurrent = borrowed.load();
+        st.idle          = available.load();
+        st.evicted       = evicted.load();
+        return st;
+    }
 private:
+    /**
+     * シャード、false sharing を避けるためキャッシュライン境界に揃える。
+     * count はロックを取らずに空かどうかを判断するためのもの。
+    */
+    struct alignas(64) Shard {
+        std::mutex m;
+        std::deque<T*> q;
+        std::atomic<std::size_t> count{0};
+    };
+    std::size_t homeIndex() const {
+        if(nshards == 1) {
+            return 0;
+        }
+        static std::atomic<std::size_t> seq{0};
+        thread_local const std::size_t home = seq.fetch_add(1);     // スレッドごとにラウンドロビンで割り当てる
+        return home % nshards;
+    }
+    void pushIdle(T* pt) const {
+        pushIdleAt(homeIndex(), pt);
+    }
+    void pushIdleAt(const std::size_t& index, T* pt) const {
+        Shard& s = shards[index];
+        {
+            std::lock_guard<std::mutex> guard(s.m);
+            s.q.push_back(pt);
+            s.count.fetch_add(1);
+        }
+        available.fetch_add(1);
+        if(waiters.load() > 0) {        // 待っているスレッドがいる場合のみ通知する（fast path では wm に触れない）
+            std::lock_guard<std::mutex> guard(wm);
+            cv.notify_one();
+        }
+    }
+    T* tryPop() const {
+        if(available.load() == 0) {
+            return nullptr;
+        }
+        const std::size_t current = borrowed.fetch_add(1) + 1;     // giveBack() と同じ理由で、先に貸し出し中を増やす
+        T* ret = takeIdle();
+        if(ret) {
+            recorder.recordCurrent(current);
+        } else {
+            borrowed.fetch_sub(1);
+        }
+        return ret;
+    }
+    /**
+     * ホームシャードから取り出し、空であれば隣のシャードから奪う。
+     * 1 周目は try_lock のみで競合しているシャードを飛ばし、2 周目でロックを待つ。
+    */
+    T* takeIdle() const {
+        if(available.load() == 0) {
+            return nullptr;
+        }
+        const std::size_t home = homeIndex();
+        for(int pass = 0; pass < 2; pass++) {
+            for(std::size_t i = 0; i < nshards; i++) {
+                Shard& s = shards[(home + i) % nshards];
+                if(s.count.load(std::memory_order_relaxed) == 0) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(s.m, std::defer_lock);
+                if(pass == 0) {
+                    if(!lock.try_lock()) {
+                        continue;
+                    }
+                } else {
+                    lock.lock();
+                }
+                if(!s.q.empty()) {
+                    return popFront(s);
+                }
+            }
+        }
+        return nullptr;
+    }
+    /**
+     * 指定したシャードからのみ取り出す（保守スレッド用）。
+    */
+    T* takeIdleAt(const std::size_t& index) const {
+        Shard& s = shards[index];
+        std::lock_guard<std::mutex> lock(s.m);
+        return s.q.empty() ? nullptr : popFront(s);
+    }
+    // s.m を取得した状態で呼ぶこと
+    T* popFront(Shard& s) const {
+        T* ret = s.q.front();
+        s.q.pop_front();
+        s.count.fetch_sub(1);
+        available.fetch_sub(1);
+        return ret;
+    }
+    void notifyEvict(const T* pt) const {
+        std::lock_guard<std::mutex> guard(hm);
+        if(evictHook) {
+            try {
+                evictHook(pt);
+            } catch(std::exception& e) {
+                ptr_print_error<const decltype(e)&>(e);       // 破棄は続ける
+            }
+        }
+    }
+    /**
+     * 保守スレッドの 1 周期分の処理。
+     * 生存確認は 1 つずつ行い、確認中のもの以外は通常通り貸し出せるようにしておく。
+     * 生きているものは同じシャードの末尾に戻す（先頭から取り出すので、各シャードの待機中を 1 周ずつ確認できる）。
+    */
+    void maintain(const std::function<bool(T*)>& ping, const std::function<T*()>& factory, const std::size_t& target) const {
+        for(std::size_t si = 0; si < nshards; si++) {
+            const std::size_t idle = shards[si].count.load();
+            for(std::size_t i = 0; i < idle; i++) {
+                T* pt = takeIdleAt(si);
+                if(!pt) {
+                    break;
+                }
+                if(checkAlive(ping, pt)) {
+                    pushIdleAt(si, pt);
+                }
+            }
+        }
+        refill(factory, target);
+    }
+    /**
+     * 貸し出し中のオブジェクトを破棄する（Lease::discard 用）。
+     * 破棄してから貸し出し中を減らすので、refill が先走って target を超えることはない。
+    */
+    void destroyBorrowed(T* pt) const {
+        evicted.fetch_add(1);
+        notifyEvict(pt);
+        delete pt;
+        borrowed.fetch_sub(1);
+    }
+    bool checkAlive(const std::function<bool(T*)>& ping, T* pt) const {
+        bool alive = false;
+        try {
+            alive = ping(pt);
+        } catch(...) {
+            alive = false;      // ping の例外は死んでいるものとして扱う
+        }
+        if(!alive) {
+            evicted.fetch_add(1);
+            notifyEvict(pt);
+            delete pt;
+        }
+        return alive;
+    }
+    /**
+     * 貸し出し中と待機中の合計が target に満たなければ factory で補充する。
+    */
+    void refill(const std::function<T*()>& factory, const std::size_t& target) const {
+        while(available.load() + borrowed.load() < target) {
+            T* pt = nullptr;
+            try {
+                pt = factory();
+            } catch(std::exception& e) {
+                ptr_print_error<const decltype(e)&>(e);
+            }
+            if(!pt) {
+                break;      // 次の周期で再試行する
+            }
+            pushIdle(pt);
+        }
+    }
     const std::string credit;
-    mutable std::mutex m;
-    mutable std::queue<T*> q;
+    const std::size_t nshards;
+    const std::unique_ptr<Shard[]> shards;
+    mutable std::atomic<std::size_t> available{0};
+    mutable std::atomic<std::size_t> borrowed{0};
+    mutable std::atomic<std::size_t> evicted{0};
+    mutable std::atomic<int> waiters{0};
+    const PoolStatsRecorder recorder;
+    mutable std::mutex wm;
+    mutable std::condition_variable cv;
+    // 保守スレッド
+    mutable std::mutex mm;
+    mutable std::condition_variable mcv;
+    mutable bool stopping = false;
+    mutable std::thread maintainer;
+    // 破棄の通知
+    mutable std::mutex hm;
+    mutable std::function<void(const T*)> evictHook;
 };
 
 #endif
@@ -0,0 +1,90 @@
+#ifndef CURSOR_H_
+#define CURSOR_H_
+
+#include <iterator>
+#include <optional>
+#include <functional>
+
+/**
+ * Cursor クラス
+ *
+ * 問い合わせ結果を 1 行ずつ取り出す range。
+ * 行は ++（次の行の要求）のたびに source から 1 つ作られ、保持するのは現在の 1 行だけなので、
+ * 100 万行のテーブルを走査してもメモリは一定で済む。
+ *
+ * source はドライバごとの ResultSet 等を所有するラムダで、行が尽きたら std::nullopt を返すこと。
+ * 入力イテレータなので、走査は 1 回限り（begin() を 2 回呼ばないこと）。
+ *
+ * e.g.
+ * for(const PersonData& p: repo.findAll(1000)) { ... }
+*/
+
+template <class DATA>
+class Cursor final {
+public:
+    using Source = std::function<std::optional<DATA>()>;
+
+    class iterator final {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = DATA;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const DATA*;
+        using reference         = const DATA&;
+
+        iterator(): cursor(nullptr)
+        {}
+        explicit iterator(Cursor<DATA>* _cursor): cursor(_cursor)
+        {}
+        const DATA& operator*() const {
+            return *cursor->current;
+        }
+        const DATA* operator->() const {
+            return &*cursor->current;
+        }
+        iterator& operator++() {
+            cursor->advance();
+            return *this;
+        }
+        void operator++(int) {
+            cursor->advance();
+        }
+        bool operator==(std::default_sentinel_t) const {
+            return !cursor || !cursor->current.has_value();
+        }
+    private:
+        Cursor<DATA>* cursor;
+    };
+
+    explicit Cursor(Source _source): source(std::move(_source))
+    {}
+    Cursor(const Cursor&)            = delete;
+    Cursor& operator=(const Cursor&) = delete;
+    Cursor(Cursor&&)                 = default;
+    Cursor& operator=(Cursor&&)      = default;
+
+    iterator begin() {
+        advance();
+        return iterator(this);
+    }
+    std::default_sentinel_t end() const {
+        return std::default_sentinel;
+    }
+    /**
+     * range-for を使わずに 1 行ずつ取り出す場合はこちら。
+    */
+    std::optional<DATA> next() {
+        return source ? source() : std::nullopt;
+    }
+private:
+    void advance() {
+        current.reset();        // DATA が代入不可（const メンバを持つ）でもよいように、代入ではなく作り直す
+        if(std::optional<DATA> row = next()) {
+            current.emplace(std::move(*row));
+        }
+    }
+    Source source;
+    std::optional<DATA> current;
+};
+
+#endif
@@ -1,12 +1,50 @@
 #ifndef DATA_FIELD_H_
 #define DATA_FIELD_H_
 
+#include <set>
+#include <mutex>
+#include <tuple>
+#include <string>
+#include <utility>
+
+/**
+ * ColumnMeta 構造体
+ *
+ * カラムのメタ情報（名前、型、制約）、同じ内容のものはプロセスで 1 つだけ作り共有する（intern）。
+ * 行ごとの DataField は値とこのポインタだけを持つので、行数分の文字列の確保とコピーが発生しない。
+*/
+
+struct ColumnMeta {
+    std::string name;
+    std::string type;
+    std::string constraint;
+    bool operator<(const ColumnMeta& o) const {
+        return std::tie(name, type, constraint) < std::tie(o.name, o.type, o.constraint);
+    }
+};
+
+/**
+ * ColumnMeta を intern する、戻り値のポインタはプロセスの終了まで有効（std::set の要素は移動しない）。
+ * 行を大量に作るホットパスでは、毎回呼ばずに取得済みのポインタを使い回すこと（ロックと比較が掛かる）。
+*/
+inline const ColumnMeta* internColumnMeta(const std::string& _name, const std::string& _type = "", const std::string& _constraint = "") {
+    static std::mutex m;
+    static std::set<ColumnMeta> metas;
+    std::lock_guard<std::mutex> guard(m);
+    return &*metas.insert(ColumnMeta{_name, _type, _constraint}).first;
+}
+
 template <class T>
 class DataField {
 public:
-    explicit DataField(const std::string& _name, const T& _value);
-    explicit DataField(const std::string& _name, const T& _value, const std::string& _type);
-    explicit DataField(const std::string& _name, const T& _value, const std::string& _type, const std::string& _constraint);
+    /**
+     * _value は値で受け取り、メンバへ move する。
+     * 一時オブジェクト（ResultSet から取り出した文字列等）を渡せば、文字列のコピーは発生しない。
+    */
+    explicit DataField(const ColumnMeta* _meta, T _value);
+    explicit DataField(const std::string& _name, T _value);
+    explicit DataField(const std::string& _name, T _value, const std::string& _type);
+    explicit DataField(const std::string& _name, T _value, const std::string& _type, const std::string& _constraint);
     // ...
     std::pair<std::string,T> bind() const;
     std::tuple<std::string, T, std::string> bindTuple() const;
@@ -15,17 +53,18 @@ public:
      * これは使い勝手の問題なので本当に必要と感じた際に実装すればいいが std::pair や std::tuple だけではなく
      * name や value のみを返却するメンバ関数は、あった方が良くはなかろうか。
     */
-    std::string getName() const {
-        return name;
+    const std::string& getName() const {
+        return meta->name;
     }
-    T getValue() const {
+    const T& getValue() const {
         return value;
     }
+    const ColumnMeta* getMeta() const {
+        return meta;
+    }
 private:
-    std::string name;
+    const ColumnMeta* meta;     // 共有のメタ情報、所有しない
     T value;
-    std::string type;
-    std::string constraint;
 };
 
 /**
@@ -33,28 +72,31 @@ private:
 */
 
 template <class T>
-DataField<T>::DataField(const std::string& _name, const T& _value): name(_name), value(_value), type{std::move(std::string(""))}
+DataField<T>::DataField(const ColumnMeta* _meta, T _value): meta(_meta), value(std::move(_value))
+{}
+template <class T>
+DataField<T>::DataField(const std::string& _name, T _value): meta(internColumnMeta(_name)), value(std::move(_value))
 {}
 template <class T>
-DataField<T>::DataField(const std::string& _name, const T& _value, const std::string& _type): 
-                        name(_name), value(_value), type(_type)
+DataField<T>::DataField(const std::string& _name, T _value, const std::string& _type): 
+                        meta(internColumnMeta(_name, _type)), value(std::move(_value))
 {}
 template <class T>
-DataField<T>::DataField(const std::string& _name, const T& _value, const std::string& _type, const std::string& _constraint): 
-                        name(_name), value(_value), type(_type), constraint(_constraint)
+DataField<T>::DataField(const std::string& _name, T _value, const std::string& _type, const std::string& _constraint): 
+                        meta(internColumnMeta(_name, _type, _constraint)), value(std::move(_value))
 {}
 // ... 
 template <class T>
 std::pair<std::string,T> DataField<T>::bind() const {
-    return {name, value};
+    return {meta->name, value};
 }
 template <class T>
 std::tuple<std::string, T, std::string> DataField<T>::bindTuple() const {
-    return {name, value, type};
+    return {meta->name, value, meta->type};
 }
 template <class T>
 std::tuple<std::string, std::string, std::string> DataField<T>::bindTupleTblInfo() const {
-    return {name, type, constraint};
+    return {meta->name, meta->type, meta->constraint};
 }
 
 #endif
@@ -2,6 +2,22 @@
 #define DEBUG_H_
 
 #include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+#include <condition_variable>
 
 template <class M, class D>
 void (*ptr_lambda_debug)(M, D) = [](const auto message, const auto debug) -> void {
@@ -18,4 +34,301 @@ void (*ptr_print_error)(Error) = [](const auto e) -> void {
     std::cout << "ERROR: " << e.what() << std::endl;
 };
 
+/**
+ * logger
+ *
+ * ライブラリ側（Repository、Connection、Strategy）のホットパス用のログ。
+ * ptr_lambda_debug、puts は std::cout（std::endl）でロックとフラッシュが毎回発生するので、こちらに置き換える。
+ *
+ * - レベルはコンパイル時に決まる（ORM_LOG_LEVEL、0:trace 1:debug 2:info 3:warn 4:error 5:off）。
+ *   未指定の場合は -DDEBUG で trace、それ以外は warn。無効なレベルの呼び出しは何も生成しない（書式化も行わない）。
+ * - 有効なレベルはスレッドごとのリングバッファ（SPSC）に書式化して積むだけで、出力はバックグラウンドのスレッドが行う。
+ *   リングが一杯の場合は待たずに捨てる（捨てた件数は後で warn で出力する）。
+ *
+ * 引数の評価自体は呼び出し側で行われるので、高価な引数は if constexpr(logger::enabled<logger::Level::debug>) で囲むこと。
+ *
+ * e.g.
+ * logger::trace("------ PersonRepository::insert");
+ * logger::debug("sql: ", sql, " ret is ", ret);
+*/
+
+#ifndef ORM_LOG_LEVEL
+#ifdef DEBUG
+#define ORM_LOG_LEVEL 0
+#else
+#define ORM_LOG_LEVEL 3
+#endif
+#endif
+
+namespace logger {
+
+enum class Level : int {
+    trace = 0
+  , debug
+  , info
+  , warn
+  , error
+  , off
+};
+
+constexpr std::string_view levelName(const Level& level) {
+    switch(level) {
+    case Level::trace:  return "TRACE: ";
+    case Level::debug:  return "DEBUG: ";
+    case Level::info:   return "INFO: ";
+    case Level::warn:   return "WARN: ";
+    case Level::error:  return "ERROR: ";
+    default:            return "";
+    }
+}
+
+namespace detail {
+
+struct Record {
+    static constexpr std::size_t CAPACITY = 240;        // これを超える部分は切り捨てる
+    Level         level = Level::off;
+    std::uint16_t size  = 0;
+    char          text[CAPACITY];
+};
+
+/**
+ * Ring クラス
+ *
+ * 書き込みは所有するスレッドのみ、読み出しは Writer のスレッドのみ（SPSC）。ロックは使わない。
+*/
+
+class Ring final {
+public:
+    static constexpr std::size_t SIZE = 256;            // 2 のべき乗
+    // 書き込む領域を得る、一杯の場合は nullptr
+    Record* claim() noexcept {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) == SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[h & (SIZE - 1)];
+    }
+    void commit() noexcept {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    template <class Sink>
+    std::size_t drain(Sink&& sink) {
+        std::size_t n = 0;
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        const std::size_t h = head.load(std::memory_order_acquire);
+        for(; t != h; t++, n++) {
+            sink(slots[t & (SIZE - 1)]);
+        }
+        tail.store(t, std::memory_order_release);
+        return n;
+    }
+    bool empty() const noexcept {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+    std::atomic<std::size_t> dropped{0};
+private:
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+    std::array<Record, SIZE> slots;
+};
+
+/**
+ * Writer クラス
+ *
+ * 全スレッドのリングを巡回して出力する。ロックはリングの登録（スレッドごとに 1 回）と flush のみ。
+ * 終了したスレッドのリングは、出力し終えた後に破棄する。
+*/
+
+class Writer final {
+public:
+    static Writer& instance() {
+        static Writer writer;
+        return writer;
+    }
+    std::shared_ptr<Ring> attach() {
+        std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(mutex);
+        rings.push_back(ring);
+        return ring;
+    }
+    void setSink(std::FILE* _sink) {
+        flush();
+        sink.store(_sink);
+    }
+    /**
+     * flush を呼んだ時点までに積まれたものが出力されるまで待つ。
+    */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        const std::size_t target = ++requested;
+        cv.notify_all();
+        cv.wait(lock, [&] { return flushed >= target; });
+    }
+    ~Writer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        if(worker.joinable()) {
+            worker.join();
+        }
+    }
+private:
+    Writer(): sink(stdout), worker([this] { run(); })
+    {}
+    Writer(const Writer&)            = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void run() {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        std::string out;
+        for(;;) {
+            std::size_t target = 0;
+            bool stop = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                target = requested;
+                stop   = stopping;
+                // 所有するスレッドが終了し（参照がここだけ）、出力し終えたリングを外す
+                std::erase_if(rings, [](const std::shared_ptr<Ring>& r) { return r.use_count() == 1 && r->empty(); });
+                snapshot = rings;
+            }
+            std::size_t n = 0;
+            for(const std::shared_ptr<Ring>& r: snapshot) {
+                n += r->drain([&](const Record& rec) {
+                    out.append(levelName(rec.level)).append(rec.text, rec.size).push_back('\n');
+                });
+                if(const std::size_t d = r->dropped.exchange(0, std::memory_order_relaxed)) {
+                    out.append(levelName(Level::warn)).append("logger dropped ").append(std::to_string(d)).append(" records\n");
+                }
+            }
+            snapshot.clear();
+            std::FILE* fp = sink.load();
+            if(!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), fp);
+                out.clear();
+            }
+            if(n > 0) {
+                continue;       // まだ積まれている可能性がある
+            }
+            std::fflush(fp);
+            std::unique_lock<std::mutex> lock(mutex);
+            if(flushed < target) {
+                flushed = target;
+                cv.notify_all();
+            }
+            if(stop) {
+                return;
+            }
+            cv.wait_for(lock, std::chrono::milliseconds(10), [&] { return stopping || requested > flushed; });
+        }
+    }
+
+    std::mutex                          mutex;
+    std::condition_variable             cv;
+    std::vector<std::shared_ptr<Ring>>  rings;
+    std::atomic<std::FILE*>             sink;
+    std::size_t                         requested = 0;
+    std::size_t                         flushed   = 0;
+    bool                                stopping  = false;
+    std::thread                         worker;
+};
+
+inline Ring& localRing() {
+    thread_local std::shared_ptr<Ring> ring = Writer::instance().attach();
+    return *ring;
+}
+
+/**
+ * 固定長の領域への書式化、メモリ確保は行わない（operator<< にしか対応しない型を除く）。
+*/
+
+class Appender final {
+public:
+    Appender(char* _begin, std::size_t _capacity): begin(_begin), cur(_begin), end(_begin + _capacity)
+    {}
+    void put(std::string_view s) {
+        const std::size_t n = std::min<std::size_t>(s.size(), end - cur);
+        std::copy_n(s.data(), n, cur);
+        cur += n;
+    }
+    template <class T>
+    void put(const T& v) {
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            put(std::string_view(v));
+        } else if constexpr (std::is_same_v<T, bool>) {
+            put(std::string_view(v ? "true" : "false"));
+        } else if constexpr (std::is_same_v<T, char>) {
+            put(std::string_view(&v, 1));
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            char buf[32];
+            auto [p, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            put(std::string_view(buf, ec == std::errc() ? p - buf : 0));
+        } else if constexpr (std::is_pointer_v<T>) {
+            char buf[2 + sizeof(void*) * 2] = {'0', 'x'};
+            auto [p, ec] = std::to_chars(buf + 2, buf + sizeof(buf), reinterpret_cast<std::uintptr_t>(v), 16);
+            put(std::string_view(buf, ec == std::errc() ? p - buf : 0));
+        } else {
+            std::ostringstream os;
+            os << v;
+            put(std::string_view(os.str()));
+        }
+    }
+    std::size_t size() const {
+        return cur - begin;
+    }
+private:
+    char* begin;
+    char* cur;
+    char* end;
+};
+
+}   // namespace detail
+
+inline void flush() {
+    detail::Writer::instance().flush();
+}
+inline void setSink(std::FILE* sink) {
+    detail::Writer::instance().setSink(sink);
+}
+
+/**
+ * レベルに依存する部分は翻訳単位ごとに持つ（無名名前空間）。
+ * Makefile の objects（-DNDEBUG）と target（-DDEBUG）でレベルが異なっても ODR 違反にならない。
+*/
+namespace {
+
+constexpr Level COMPILED_LEVEL = static_cast<Level>(ORM_LOG_LEVEL);
+
+template <Level L>
+constexpr bool enabled = L != Level::off && static_cast<int>(L) >= static_cast<int>(COMPILED_LEVEL);
+
+template <Level L, class... Args>
+inline void log([[maybe_unused]] const Args&... args) {
+    if constexpr (enabled<L>) {
+        detail::Ring& ring = detail::localRing();
+        detail::Record* rec = ring.claim();
+        if(!rec) {
+            return;
+        }
+        detail::Appender out(rec->text, detail::Record::CAPACITY);
+        (out.put(args), ...);
+        rec->level = L;
+        rec->size  = static_cast<std::uint16_t>(out.size());
+        ring.commit();
+    }
+}
+
+template <class... Args> inline void trace(const Args&... args) { log<Level::trace>(args...); }
+template <class... Args> inline void debug(const Args&... args) { log<Level::debug>(args...); }
+template <class... Args> inline void info(const Args&... args)  { log<Level::info>(args...); }
+template <class... Args> inline void warn(const Args&... args)  { log<Level::warn>(args...); }
+template <class... Args> inline void error(const Args&... args) { log<Level::error>(args...); }
+
+}   // namespace
+
+}   // namespace logger
+
 #endif
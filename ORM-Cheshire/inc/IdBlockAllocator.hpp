@@ -0,0 +1,161 @@
+#ifndef IDBLOCKALLOCATOR_H_
+#define IDBLOCKALLOCATOR_H_
+
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+#include "Debug.hpp"
+
+/**
+ * IdBlockAllocator クラス
+ *
+ * シーケンスで採番するプライマリキを、blockSize 個ずつまとめて予約してメモリから払い出す（hi-lo の考え方）。
+ * insert ごとの SELECT nextval(...) の往復を無くし、insert を 1 往復にするためのもの。
+ *
+ * - 残りが lowWater を下回ると、専用のスレッドで次のブロックを予約する（払い出しを止めない）。
+ *   補充が間に合わず空になった場合だけ、next() は補充を待つ。
+ * - 予約は reserve（blockSize を受け取り、予約したキーを返す関数）で行う。reserve は呼び出し側のトランザクションとは
+ *   別のコネクションで実行されるので、専用のコネクションを持たせること（nextval はロールバックされないので問題ない）。
+ * - 予約したキーは払い出さずに終了すると欠番になる。キーの連続性は保証しない、一意性だけを保証する。
+ * - スレッド間で共有してよい。
+ *
+ * e.g.
+ * IdBlockAllocator<long> ids(pgsqlSequenceReserve(appProp.pqx.toString(), "table_id_seq"), 1000);
+ * CompanyRepository repo(&tx, &ids);
+*/
+
+template <class ID>
+class IdBlockAllocator final {
+public:
+    using Reserve = std::function<std::vector<ID>(const std::size_t&)>;
+
+    IdBlockAllocator(Reserve _reserve, const std::size_t& _blockSize = 1000, const std::size_t& _lowWater = 0)
+    : reserve(std::move(_reserve))
+    , blockSize(_blockSize ? _blockSize : 1)
+    , lowWater(_lowWater ? std::min(_lowWater, blockSize) : std::max<std::size_t>(1, blockSize / 4))
+    , worker([this] { run(); })
+    {}
+    IdBlockAllocator(const IdBlockAllocator&)            = delete;
+    IdBlockAllocator& operator=(const IdBlockAllocator&) = delete;
+    ~IdBlockAllocator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+    ID next() {
+        std::unique_lock<std::mutex> lock(mutex);
+        await(lock, 1);
+        ID id = ids.front();
+        ids.pop_front();
+        wakeIfLow();
+        return id;
+    }
+    /**
+     * n 個のキーをまとめて払い出す（insertMany 等）。1 ブロックを超える場合は、補充を繰り返し待つ。
+    */
+    std::vector<ID> next(const std::size_t& n) {
+        std::vector<ID> result;
+        result.reserve(n);
+        std::unique_lock<std::mutex> lock(mutex);
+        while(result.size() < n) {
+            await(lock, 1);
+            const std::size_t take = std::min(n - result.size(), ids.size());
+            result.insert(result.end(), ids.begin(), ids.begin() + take);
+            ids.erase(ids.begin(), ids.begin() + take);
+            wakeIfLow();
+        }
+        return result;
+    }
+    std::size_t available() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ids.size();
+    }
+    // ブロックを予約した回数、空で補充を待った回数（検証、計測用）
+    std::size_t refillCount() const {
+        return refills.load();
+    }
+    std::size_t stallCount() const {
+        return stalls.load();
+    }
+private:
+    // mutex を取得した状態で呼ぶこと
+    void await(std::unique_lock<std::mutex>& lock, const std::size_t& n) {
+        if(ids.size() >= n) {
+            return;
+        }
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        cv.notify_all();
+        cv.wait(lock, [this, &n] { return ids.size() >= n || error || stopping; });
+        if(ids.size() >= n) {
+            return;
+        }
+        if(error) {
+            std::exception_ptr e = std::exchange(error, nullptr);      // 次の呼び出しで再び予約を試みる
+            cv.notify_all();
+            try {
+                std::rethrow_exception(e);
+            } catch(std::exception& ex) {
+                throw std::runtime_error(ex.what());
+            }
+        }
+        throw std::runtime_error("IdBlockAllocator is stopping.");
+    }
+    void wakeIfLow() {
+        if(ids.size() < lowWater) {
+            cv.notify_all();
+        }
+    }
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;) {
+            cv.wait(lock, [this] { return stopping || (ids.size() < lowWater && !error); });
+            if(stopping) {
+                return;
+            }
+            lock.unlock();
+            std::vector<ID> block;
+            std::exception_ptr failed;
+            try {
+                block = reserve(blockSize);
+                logger::debug("IdBlockAllocator reserved ", block.size(), " ids.");
+            } catch(std::exception& e) {
+                logger::error("IdBlockAllocator reserve failed: ", e.what());
+                failed = std::current_exception();
+            }
+            lock.lock();
+            if(failed || block.empty()) {
+                // 待っている next() に返す。失敗が続いても空回りしないよう、next() が取り出すまで次を試みない
+                error = failed ? failed : std::make_exception_ptr(std::runtime_error("IdBlockAllocator reserved no ids."));
+            } else {
+                ids.insert(ids.end(), block.begin(), block.end());
+                refills.fetch_add(1, std::memory_order_relaxed);
+            }
+            cv.notify_all();
+        }
+    }
+
+    Reserve                     reserve;
+    const std::size_t           blockSize;
+    const std::size_t           lowWater;
+    mutable std::mutex          mutex;
+    std::condition_variable     cv;
+    std::deque<ID>              ids;
+    std::exception_ptr          error;
+    bool                        stopping = false;
+    std::atomic<std::size_t>    refills{0};
+    std::atomic<std::size_t>    stalls{0};
+    std::thread                 worker;
+};
+
+#endif
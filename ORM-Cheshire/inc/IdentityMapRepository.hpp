@@ -0,0 +1,149 @@
+#ifndef IDENTITYMAPREPOSITORY_H_
+#define IDENTITYMAPREPOSITORY_H_
+
+#include <span>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "Debug.hpp"
+#include "Repository.hpp"
+
+/**
+ * IdentityMapRepository クラス
+ *
+ * 1 つのトランザクション（作業単位）の中で、同じプライマリキの findOne を 2 回目以降サーバに問い合わせないための
+ * Repository のデコレータ。読み込んだもの、書き込んだものをキーごとに保持する（存在しないことも保持する）。
+ *
+ * - findOne、findByIds は保持しているものを返し、無いものだけを inner に問い合わせる。
+ * - insert、update は戻り値（書き込んだ結果）で保持しているものを置き換える。戻り値が無い（ResultPolicy::NO_ECHO）場合は破棄する。
+ * - remove は「存在しない」として保持する。insertMany は採番されたキーの保持を破棄する。
+ * - upsert は戻り値で保持しているものを置き換える。戻り値が無い場合と upsertMany は、UNIQUE の重複でどの行が更新されたか
+ *   わからないので、保持しているものをすべて破棄する。
+ * - findAll は保持の対象外（そのまま inner に委譲する）。
+ *
+ * トランザクションごとに作り（Strategy より先に、同じコネクションの Repository を包む）、executeTx の後に破棄すること。
+ * ロールバックした場合は保持しているものが正しくないので、再利用しないこと（clear() で捨てることはできる）。
+ * スレッドセーフではない、トランザクションと同じく 1 つのスレッドで使うこと。
+ *
+ * e.g.
+ * PersonRepository repo(&mcon, ResultPolicy::ECHO);      // update 後の再取得も省く
+ * IdentityMapRepository<PersonData, std::size_t> uow(&repo, [](const PersonData& d) { return d.getId().getValue(); });
+ * MySQLUpdateStrategy<PersonData, std::size_t> strategy(&uow, data);
+*/
+
+template <class DATA, class PKEY>
+class IdentityMapRepository final : public Repository<DATA, PKEY> {
+public:
+    using KeyOf = std::function<PKEY(const DATA&)>;
+
+    IdentityMapRepository(const Repository<DATA, PKEY>* _inner, KeyOf _keyOf): inner(_inner), keyOf(std::move(_keyOf))
+    {}
+    virtual std::optional<DATA> insert(const DATA& data) const override {
+        std::optional<DATA> result = inner->insert(data);
+        if(result.has_value()) {
+            put(keyOf(result.value()), result);
+        }
+        return result;
+    }
+    virtual std::optional<DATA> update(const DATA& data) const override {
+        const PKEY pkey = keyOf(data);
+        std::optional<DATA> result = inner->update(data);
+        if(result.has_value()) {
+            put(pkey, result);
+        } else {
+            map.erase(pkey);        // 書き込み後の状態がわからない
+        }
+        return result;
+    }
+    virtual void remove(const PKEY& pkey) const override {
+        inner->remove(pkey);
+        put(pkey, std::nullopt);
+    }
+    virtual std::optional<DATA> findOne(const PKEY& pkey) const override {
+        auto it = map.find(pkey);
+        if(it != map.end()) {
+            hits++;
+            return it->second;
+        }
+        misses++;
+        std::optional<DATA> result = inner->findOne(pkey);
+        put(pkey, result);
+        return result;
+    }
+    virtual std::vector<PKEY> insertMany(std::span<const DATA> datas, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        std::vector<PKEY> pkeys = inner->insertMany(datas, chunkSize);
+        for(const PKEY& k: pkeys) {
+            map.erase(k);
+        }
+        return pkeys;
+    }
+    virtual std::optional<DATA> upsert(const DATA& data) const override {
+        std::optional<DATA> result = inner->upsert(data);
+        if(result.has_value()) {
+            put(keyOf(result.value()), result);
+        } else {
+            map.clear();
+        }
+        return result;
+    }
+    virtual void upsertMany(std::span<const DATA> datas, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        map.clear();
+        inner->upsertMany(datas, chunkSize);
+    }
+    virtual FindResult<DATA, PKEY> findByIds(std::span<const PKEY> pkeys, const std::size_t& chunkSize = Repository<DATA, PKEY>::DEFAULT_CHUNK_SIZE) const override {
+        std::vector<PKEY> unknown;
+        std::unordered_set<PKEY> seen;
+        for(const PKEY& k: pkeys) {
+            if(map.find(k) == map.end() && seen.insert(k).second) {
+                unknown.push_back(k);
+            }
+        }
+        hits   += pkeys.size() - unknown.size();
+        misses += unknown.size();
+        if(!unknown.empty()) {
+            FindResult<DATA, PKEY> fetched = inner->findByIds(std::span<const PKEY>(unknown), chunkSize);
+            for(std::size_t i = 0; i < unknown.size(); i++) {
+                put(unknown[i], fetched.rows[i]);
+            }
+        }
+        FindResult<DATA, PKEY> result;
+        result.rows.reserve(pkeys.size());
+        seen.clear();
+        for(const PKEY& k: pkeys) {
+            const std::optional<DATA>& row = map.at(k);
+            result.rows.push_back(row);
+            if(!row.has_value() && seen.insert(k).second) {
+                result.missing.push_back(k);
+            }
+        }
+        return result;
+    }
+    virtual Cursor<DATA> findAll(const std::size_t& fetchSize = Repository<DATA, PKEY>::DEFAULT_FETCH_SIZE) const override {
+        return inner->findAll(fetchSize);
+    }
+    void clear() const {
+        map.clear();
+    }
+    // 保持していたもので応えた回数、inner に問い合わせた回数（検証、計測用）
+    std::size_t hitCount() const {
+        return hits;
+    }
+    std::size_t missCount() const {
+        return misses;
+    }
+private:
+    void put(const PKEY& pkey, const std::optional<DATA>& data) const {
+        // DATA が代入不可（const メンバを持つ）でもよいように、代入ではなく作り直す
+        map.erase(pkey);
+        map.emplace(pkey, data);
+    }
+    const Repository<DATA, PKEY>*                       inner;
+    KeyOf                                               keyOf;
+    mutable std::unordered_map<PKEY, std::optional<DATA>> map;
+    mutable std::size_t                                 hits   = 0;
+    mutable std::size_t                                 misses = 0;
+};
+
+#endif
@@ -1,17 +1,29 @@
 #ifndef MYSQLCONNECTION_H_
 #define MYSQLCONNECTION_H_
 
+#include <list>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include "Debug.hpp"
 #include "RdbConnection.hpp"
 // 当時のこれでいいでしょ感がすごいな
 #include "/usr/include/mysql-cppconn-8/mysql/jdbc.h"
 
 /**
  * MySQL 用コネクション
+ * 
+ * SQL 文をキーにした Prepared Statement の LRU キャッシュを持つ。
+ * 同じ SQL を毎回 prepareStatement すると、そのたびにサーバ側の PREPARE が往復するため。
+ * キャッシュを活かすには、本クラスのオブジェクトを sql::Connection と同じ寿命で保持すること
+ * （CRUD のたびに作り直すとキャッシュも毎回空になる）。
 */
 
 class MySQLConnection final : public RdbConnection<sql::PreparedStatement> {
 public:
-    MySQLConnection(sql::Connection* _con): con(_con)
+    MySQLConnection(sql::Connection* _con): MySQLConnection(_con, DEFAULT_STATEMENT_CACHE_SIZE)
+    {}
+    MySQLConnection(sql::Connection* _con, const std::size_t& _cacheSize): con(_con), cacheSize(_cacheSize ? _cacheSize : 1)
     {}
     // ...
     virtual void begin() const override;
@@ -19,8 +31,21 @@ public:
     virtual void rollback() const override;
     virtual sql::PreparedStatement* prepareStatement(const std::string& sql) const override;
     sql::Statement* createStatement() const;
+    /**
+     * キャッシュ済みの Prepared Statement を返す、パラメータはクリア済み。
+     * 所有権は本クラスにあるので delete（std::unique_ptr で包むこと）はしないこと。
+     * 返却されたポインタは、キャッシュから追い出されるまで（cacheSize 個の別の SQL が使われるまで）有効。
+     * キャッシュにある場合は std::string を作らない（constexpr で生成した SQL をそのまま渡せる）。
+    */
+    sql::PreparedStatement* prepareCachedStatement(std::string_view sql) const;
+    std::size_t cachedStatementCount() const;
+    static constexpr std::size_t DEFAULT_STATEMENT_CACHE_SIZE = 32;
 private:
+    using CacheEntry = std::pair<std::string, std::unique_ptr<sql::PreparedStatement>>;
     sql::Connection* con;
+    const std::size_t cacheSize;
+    mutable std::list<CacheEntry> lru;          // 先頭が最も最近使われたもの
+    mutable std::unordered_map<std::string_view, std::list<CacheEntry>::iterator> cache;     // キーは lru 側の文字列を指す
     // void begin_() const { con->setAutoCommit(false); }
 };
 
@@ -1,7 +1,9 @@
 #ifndef MYSQLCREATESTRATEGY_H_
 #define MYSQLCREATESTRATEGY_H_
 
+#include "Debug.hpp"
 #include <optional>
+#include <utility>
 
 /**
  * MySQLCreateStrategy クラス
@@ -17,10 +19,13 @@
 template <class DATA, class PKEY>
 class MySQLCreateStrategy final : public RdbProcStrategy<DATA> {
 public:
-    MySQLCreateStrategy(const Repository<DATA,PKEY>* _repo, const DATA& _data): repo(_repo), data(_data) 
+    /**
+     * _data は値で受け取り move する。呼び出し側が std::move で渡せば、エンティティのコピーは発生しない。
+    */
+    MySQLCreateStrategy(const Repository<DATA,PKEY>* _repo, DATA _data): repo(_repo), data(std::move(_data)) 
     {}
     virtual std::optional<DATA> proc() const override {
-        puts("------ MySQLCreateStrategy::proc");
+        logger::trace("------ MySQLCreateStrategy::proc");
         try {
             return repo->insert(data);
         } catch(std::exception& e) {
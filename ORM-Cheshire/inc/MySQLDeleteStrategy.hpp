@@ -1,9 +1,11 @@
 #ifndef MYSQLDELETESTRATEGY_H_
 #define MYSQLDELETESTRATEGY_H_
 
+#include "Debug.hpp"
 #include "RdbProcStrategy.hpp"
 #include "Repository.hpp"
 #include <optional>
+#include <utility>
 
 /**
  * MySQLDeleteStrategy クラス
@@ -14,12 +16,12 @@
 template <class DATA, class PKEY>
 class MySQLDeleteStrategy final : public RdbProcStrategy<DATA> {
 public:
-    MySQLDeleteStrategy(const Repository<DATA,PKEY>* _repo, const PKEY& _pkey)
+    MySQLDeleteStrategy(const Repository<DATA,PKEY>* _repo, PKEY _pkey)
     : repo(_repo)
-    , pkey(_pkey)
+    , pkey(std::move(_pkey))
     {}
     virtual std::optional<DATA> proc() const override {
-        puts("------ MySQLDeleteStrategy::proc");
+        logger::trace("------ MySQLDeleteStrategy::proc");
         try {
             repo->remove(pkey);
             return std::nullopt;
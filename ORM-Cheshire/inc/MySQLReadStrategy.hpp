@@ -1,9 +1,11 @@
 #ifndef MYSQLREADSTRATEGY_H_
 #define MYSQLREADSTRATEGY_H_
 
+#include "Debug.hpp"
 #include "RdbProcStrategy.hpp"
 #include "Repository.hpp"
 #include <optional>
+#include <utility>
 
 /**
  * MySQLReadStrategy クラス
@@ -14,14 +16,15 @@
 template <class DATA, class PKEY>
 class MySQLReadStrategy final : public RdbProcStrategy<DATA> {
 public:
-    MySQLReadStrategy(const Repository<DATA,PKEY>* _repo, const PKEY& _pkey)
+    MySQLReadStrategy(const Repository<DATA,PKEY>* _repo, PKEY _pkey)
     : repo(_repo)
-    , pkey(_pkey)
+    , pkey(std::move(_pkey))
     {}
+    static constexpr bool READ_ONLY = true;
     virtual std::optional<DATA> proc() const override {
-        puts("------ MySQLReadStrategy::proc");
+        logger::trace("------ MySQLReadStrategy::proc");
         try {
-            return repo->findOne(pkey);
+            return repo->findOne(pkey);         // 結果の optional はそのまま返す（NRVO、コピーしない）
         } catch(std::exception& e) {
             throw std::runtime_error(e.what());
         }
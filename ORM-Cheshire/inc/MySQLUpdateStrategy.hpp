@@ -1,9 +1,11 @@
 #ifndef MYSQLUPDATESTRATEGY_H_
 #define MYSQLUPDATESTRATEGY_H_
 
+#include "Debug.hpp"
 #include "RdbProcStrategy.hpp"
 #include "Repository.hpp"
 #include <optional>
+#include <utility>
 
 /**
  * MySQLUpdateStrategy クラス
@@ -14,12 +16,13 @@
 template <class DATA, class PKEY>
 class MySQLUpdateStrategy final : public RdbProcStrategy<DATA> {
 public:
-    MySQLUpdateStrategy(const Repository<DATA,PKEY>* _repo, const DATA& _data)
+    // _data は値で受け取り move する（MySQLCreateStrategy と同じ）
+    MySQLUpdateStrategy(const Repository<DATA,PKEY>* _repo, DATA _data)
     : repo(_repo)
-    , data(_data)
+    , data(std::move(_data))
     {}
     virtual std::optional<DATA> proc() const override {
-        puts("------ MySQLUpdateStrategy::proc");
+        logger::trace("------ MySQLUpdateStrategy::proc");
         try {
             return repo->update(data);
         } catch(std::exception& e) {
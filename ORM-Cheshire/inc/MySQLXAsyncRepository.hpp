@@ -0,0 +1,167 @@
+#ifndef MYSQLXASYNCREPOSITORY_H_
+#define MYSQLXASYNCREPOSITORY_H_
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include "Debug.hpp"
+
+namespace ormx {
+
+/**
+ * MySQLXAsyncRepository クラス
+ *
+ * mysqlx のリポジトリ（ormx::PersonRepository、ormx2::MySQLXBasicRepository 等）の非同期版。
+ * 文をセッション専用の worker スレッドのキューに積み、std::future を返す。
+ * 呼び出し側は結果を待たずに次の文を積めるので、複数の文からなる業務処理でネットワークの待ち時間を隠せる。
+ *
+ * - 公開されている X DevAPI（C++）には非同期の execute が無いので、worker が積まれた順に 1 つずつ execute する。
+ *   1 つのセッションの文は順に実行される（後に積んだ文は先に積んだ文の結果を見る）。
+ * - flush() は、それまでに積んだ文がすべて完了するまで待つ（業務処理の区切り）。文の失敗は各 future に例外で返す。
+ * - キューは capacity までで、一杯の場合は空きができるまで待つ（背圧）。
+ * - repo（とそのセッション）は本クラスの生存期間中、worker だけが使う。呼び出し側から直接使わないこと。
+ *
+ * e.g.
+ * ormx::PersonRepository repo(lease.get(), &app_xh);
+ * ormx::MySQLXAsyncRepository<ormx::PersonRepository> async(&repo);
+ * auto f1 = async.insert(alice);
+ * auto f2 = async.findOne(pkey);
+ * async.flush();
+ * std::optional<ormx::PersonData> a = f1.get();
+*/
+
+template <class REPO>
+class MySQLXAsyncRepository final {
+public:
+    MySQLXAsyncRepository(const REPO* _repo, const std::size_t& _capacity = 256)
+    : repo(_repo), capacity(_capacity ? _capacity : 1), worker([this] { run(); })
+    {}
+    MySQLXAsyncRepository(const MySQLXAsyncRepository&)            = delete;
+    MySQLXAsyncRepository& operator=(const MySQLXAsyncRepository&) = delete;
+    /**
+     * キューに残っているものを実行し終えてから終了する。
+    */
+    ~MySQLXAsyncRepository() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+        worker.join();
+    }
+    /**
+     * 任意の処理を積む、f は const REPO& を受け取る。
+    */
+    template <class F>
+    std::future<std::invoke_result_t<F&, const REPO&>> submit(F f) {
+        using R = std::invoke_result_t<F&, const REPO&>;
+        auto task = std::make_shared<std::packaged_task<R()>>([this, f = std::move(f)]() mutable { return f(*repo); });
+        std::future<R> future = task->get_future();
+        enqueue([task] { (*task)(); });
+        return future;
+    }
+    template <class DATA>
+    auto insert(DATA data) {
+        return submit([data = std::move(data)](const REPO& r) { return r.insert(data); });
+    }
+    template <class DATA>
+    auto update(DATA data) {
+        return submit([data = std::move(data)](const REPO& r) { return r.update(data); });
+    }
+    template <class DATA>
+    auto upsert(DATA data) {
+        return submit([data = std::move(data)](const REPO& r) { return r.upsert(data); });
+    }
+    template <class PKEY>
+    auto remove(PKEY pkey) {
+        return submit([pkey = std::move(pkey)](const REPO& r) { return r.remove(pkey); });
+    }
+    template <class PKEY>
+    auto findOne(PKEY pkey) {
+        return submit([pkey = std::move(pkey)](const REPO& r) { return r.findOne(pkey); });
+    }
+    /**
+     * datas、pkeys は実行されるまで本クラスが保持する（呼び出し側の span の寿命を気にしなくてよい）。
+    */
+    template <class DATA>
+    auto insertMany(std::vector<DATA> datas) {
+        return submit([datas = std::move(datas)](const REPO& r) { return r.insertMany(datas); });
+    }
+    template <class DATA>
+    auto upsertMany(std::vector<DATA> datas) {
+        return submit([datas = std::move(datas)](const REPO& r) { r.upsertMany(datas); });
+    }
+    template <class PKEY>
+    auto findByIds(std::vector<PKEY> pkeys) {
+        return submit([pkeys = std::move(pkeys)](const REPO& r) { return r.findByIds(pkeys); });
+    }
+    /**
+     * それまでに積んだ文がすべて完了するまで待つ。
+    */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return queue.empty() && !running; });
+    }
+    // 積まれていて、まだ完了していない文の数
+    std::size_t pendingCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size() + (running ? 1 : 0);
+    }
+private:
+    void enqueue(std::function<void()> task) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return stopping || queue.size() < capacity; });
+        if(stopping) {
+            throw std::runtime_error("MySQLXAsyncRepository is stopping.");
+        }
+        queue.push_back(std::move(task));
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+    void run() {
+        for(;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+                if(queue.empty()) {
+                    return;         // stopping かつ残りなし
+                }
+                task = std::move(queue.front());
+                queue.pop_front();
+                running = true;
+            }
+            notFull.notify_one();
+            task();                 // 例外は packaged_task が future に入れる
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+            idle.notify_all();
+        }
+    }
+
+    const REPO*                         repo;
+    const std::size_t                   capacity;
+    mutable std::mutex                  mutex;
+    std::condition_variable             notEmpty;
+    std::condition_variable             notFull;
+    std::condition_variable             idle;
+    std::deque<std::function<void()>>   queue;
+    bool                                running  = false;
+    bool                                stopping = false;
+    std::thread                         worker;
+};
+
+}   // namespace ormx
+
+#endif
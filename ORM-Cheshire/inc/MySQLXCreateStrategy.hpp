@@ -1,18 +1,21 @@
 #ifndef MYSQLXCREATESTRATEGY_H_
 #define MYSQLXCREATESTRATEGY_H_
 
+#include "Debug.hpp"
 #include "Repository.hpp"
 #include "RdbProcStrategy.hpp"
+#include <utility>
 
 namespace ormx {
 template<class DATA, class PKEY>
 class MySQLXCreateStrategy final : public RdbProcStrategy<DATA> {
 public:
-    MySQLXCreateStrategy(const Repository<DATA, PKEY>* _repo, const DATA& _data): repo(_repo), data(_data)
+    // _data は値で受け取り move する（MySQLCreateStrategy と同じ）
+    MySQLXCreateStrategy(const Repository<DATA, PKEY>* _repo, DATA _data): repo(_repo), data(std::move(_data))
     {}
     // ...
     virtual std::optional<DATA> proc() const override {
-        puts("------ ormx::MySQLXCreateStrategy::proc()");
+        logger::trace("------ ormx::MySQLXCreateStrategy::proc()");
         try {
             return repo->insert(data);
         } catch(std::exception& e) {
@@ -0,0 +1,195 @@
+#ifndef MYSQLXGROUPCOMMIT_H_
+#define MYSQLXGROUPCOMMIT_H_
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <optional>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include "Debug.hpp"
+#include "MySQLXTx.hpp"
+#include "RdbProcStrategy.hpp"
+#include "/usr/include/mysql-cppconn-8/mysqlx/xdevapi.h"
+
+namespace ormx {
+
+/**
+ * MySQLXGroupCommit クラス
+ *
+ * 小さな MySQLXTx をリクエストごとにコミットすると、コミットのたびにサーバ側で fsync が発生する。
+ * 本クラスは window（時間）あるいは maxBatch（件数）の間に届いた処理を、1 つのセッションの 1 つのトランザクションにまとめてコミットする。
+ *
+ * - 処理ごとに SAVEPOINT を置くので、処理自身の失敗（一意制約違反等）はその処理だけを取り消し、呼び出し側に例外で返す。
+ * - まとめたトランザクションそのものが失敗した場合（コミットの失敗、デッドロックによる全体のロールバック等）は、
+ *   全体をロールバックしてから、各処理を個別の MySQLXTx で再実行する。1 つの不良な行が隣の処理を巻き込まないようにするためのもの。
+ * - session は本クラスのスレッドだけが使う、生存期間中に他から利用しないこと。
+ *
+ * 処理は RdbProcStrategy（session 上のリポジトリを使うもの）、あるいは session を受け取る関数で渡す。
+ * 再実行される可能性があるので、処理は何度実行しても同じ結果になるよう、自身の状態を変更しないこと。
+*/
+
+template <class DATA>
+class MySQLXGroupCommit final {
+public:
+    using Proc = std::function<std::optional<DATA>(mysqlx::Session*)>;
+
+    MySQLXGroupCommit(mysqlx::Session* _session
+        , const std::size_t& _maxBatch = 64
+        , const std::chrono::microseconds& _window = std::chrono::microseconds(500))
+    : session(_session), maxBatch(_maxBatch ? _maxBatch : 1), window(_window), worker([this] { run(); })
+    {}
+    MySQLXGroupCommit(const MySQLXGroupCommit&)            = delete;
+    MySQLXGroupCommit& operator=(const MySQLXGroupCommit&) = delete;
+    /**
+     * 積まれているものをコミットしてから終了する。
+    */
+    ~MySQLXGroupCommit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+    std::future<std::optional<DATA>> submit(Proc proc) {
+        Item item{std::move(proc), std::promise<std::optional<DATA>>()};
+        std::future<std::optional<DATA>> future = item.promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(stopping) {
+                throw std::runtime_error("MySQLXGroupCommit is stopping.");
+            }
+            queue.push_back(std::move(item));
+        }
+        cv.notify_one();
+        return future;
+    }
+    /**
+     * strategy は future が完了するまで有効であること。
+    */
+    std::future<std::optional<DATA>> submit(std::shared_ptr<const RdbProcStrategy<DATA>> strategy) {
+        return submit([strategy](mysqlx::Session*) { return strategy->proc(); });
+    }
+    mysqlx::Session* getSession() const {
+        return session;
+    }
+    // まとめてコミットした回数、個別に再実行した回数（検証、計測用）
+    std::size_t batchCount() const {
+        return batches.load();
+    }
+    std::size_t retryCount() const {
+        return retries.load();
+    }
+private:
+    struct Item {
+        Proc proc;
+        std::promise<std::optional<DATA>> promise;
+    };
+    /**
+     * Proc を MySQLXTx に渡すための RdbProcStrategy（個別の再実行で使う）。
+    */
+    class ProcStrategy final : public RdbProcStrategy<DATA> {
+    public:
+        ProcStrategy(const Proc* _fn, mysqlx::Session* _session): fn(_fn), session(_session)
+        {}
+        virtual std::optional<DATA> proc() const override {
+            return (*fn)(session);
+        }
+    private:
+        const Proc* fn;
+        mysqlx::Session* session;
+    };
+
+    void run() {
+        std::vector<Item> batch;
+        batch.reserve(maxBatch);
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if(queue.empty()) {
+                    return;         // stopping かつ残りなし
+                }
+                // 最初の 1 件から window の間、あるいは maxBatch に達するまで集める
+                const auto deadline = std::chrono::steady_clock::now() + window;
+                cv.wait_until(lock, deadline, [this] { return stopping || queue.size() >= maxBatch; });
+                while(!queue.empty() && batch.size() < maxBatch) {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            commitBatch(batch);
+            batch.clear();
+        }
+    }
+    void commitBatch(std::vector<Item>& batch) {
+        logger::trace("------ ormx::MySQLXGroupCommit::commitBatch() size is ", batch.size());
+        std::vector<std::optional<DATA>> results(batch.size());
+        std::vector<std::exception_ptr>  errors(batch.size());
+        try {
+            session->startTransaction();
+            for(std::size_t i = 0; i < batch.size(); i++) {
+                const std::string savepoint = session->setSavepoint();
+                try {
+                    results[i] = batch[i].proc(session);
+                } catch(std::exception& e) {
+                    // この処理だけを取り消す、ここで失敗する場合はトランザクション全体が失われている
+                    session->rollbackTo(savepoint);
+                    errors[i] = std::make_exception_ptr(std::runtime_error(e.what()));
+                }
+            }
+            session->commit();
+            batches.fetch_add(1);
+        } catch(std::exception& e) {
+            logger::warn("ormx::MySQLXGroupCommit batch failed, retry individually: ", e.what());
+            try {
+                session->rollback();
+            } catch(std::exception& re) {
+                logger::error("ormx::MySQLXGroupCommit rollback failed: ", re.what());
+            }
+            retryIndividually(batch);
+            return;
+        }
+        for(std::size_t i = 0; i < batch.size(); i++) {
+            if(errors[i]) {
+                batch[i].promise.set_exception(errors[i]);
+            } else {
+                batch[i].promise.set_value(std::move(results[i]));
+            }
+        }
+    }
+    void retryIndividually(std::vector<Item>& batch) {
+        for(Item& item: batch) {
+            retries.fetch_add(1);
+            try {
+                ProcStrategy strategy(&item.proc, session);
+                MySQLXTx<DATA> tx(session, &strategy);
+                item.promise.set_value(tx.executeTx());
+            } catch(...) {
+                item.promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    mysqlx::Session*                session;
+    const std::size_t               maxBatch;
+    const std::chrono::microseconds window;
+    std::mutex                      mutex;
+    std::condition_variable         cv;
+    std::deque<Item>                queue;
+    bool                            stopping = false;
+    std::atomic<std::size_t>        batches{0};
+    std::atomic<std::size_t>        retries{0};
+    std::thread                     worker;
+};
+
+}   // namespace ormx
+
+#endif
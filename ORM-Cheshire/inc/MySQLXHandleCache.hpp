@@ -0,0 +1,99 @@
+#ifndef MYSQLXHANDLECACHE_H_
+#define MYSQLXHANDLECACHE_H_
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include "Debug.hpp"
+#include "/usr/include/mysql-cppconn-8/mysqlx/xdevapi.h"
+
+namespace ormx {
+
+/**
+ * MySQLXHandleCache クラス
+ *
+ * セッションごとの Schema、Table オブジェクトのキャッシュ。
+ * getSchema()、getTable() の結果を最初の 1 回だけ作り、以降の CRUD は文そのものの処理だけにするためのもの。
+ *
+ * Table はセッションを参照するので、セッションを破棄（Pool から evict、作り直し）する前に invalidate() すること。
+ * Pool を使う場合は ConnectionPool::onEvict に invalidate を登録する。
+ * 同じセッションを同時に複数のスレッドで使わない限り、スレッド間で共有してよい（セッション自体がそういうもの）。
+ *
+ * e.g.
+ * ormx::MySQLXHandleCache handles;
+ * pool.onEvict([&handles](const mysqlx::Session* s) { handles.invalidate(s); });
+ * ormx::PersonRepository repo(lease.get(), &handles);
+*/
+
+class MySQLXHandleCache final {
+public:
+    MySQLXHandleCache()                                    = default;
+    MySQLXHandleCache(const MySQLXHandleCache&)            = delete;
+    MySQLXHandleCache& operator=(const MySQLXHandleCache&) = delete;
+
+    /**
+     * 戻り値の参照は、そのセッションを invalidate() するまで有効。
+    */
+    mysqlx::Schema& schema(mysqlx::Session* session, const std::string& name) {
+        std::lock_guard<std::mutex> guard(m);
+        return schemaLocked(session, name);
+    }
+    mysqlx::Table& table(mysqlx::Session* session, const std::string& schemaName, const std::string& tableName) {
+        std::lock_guard<std::mutex> guard(m);
+        Handles& h = handles[session];
+        std::string key(schemaName);
+        key.append(".").append(tableName);
+        auto it = h.tables.find(key);
+        if(it != h.tables.end()) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        logger::debug("MySQLXHandleCache resolve ", key);
+        return h.tables.emplace(std::move(key), schemaLocked(session, schemaName).getTable(tableName)).first->second;
+    }
+    void invalidate(const mysqlx::Session* session) {
+        std::lock_guard<std::mutex> guard(m);
+        handles.erase(session);
+    }
+    void clear() {
+        std::lock_guard<std::mutex> guard(m);
+        handles.clear();
+    }
+    // キャッシュしているセッションの数
+    std::size_t size() const {
+        std::lock_guard<std::mutex> guard(m);
+        return handles.size();
+    }
+    // Table をキャッシュから返した回数、作った回数（検証、計測用）
+    std::size_t hitCount() const {
+        return hits.load();
+    }
+    std::size_t missCount() const {
+        return misses.load();
+    }
+private:
+    struct Handles {
+        std::unordered_map<std::string, mysqlx::Schema> schemas;
+        std::unordered_map<std::string, mysqlx::Table>  tables;        // キーは "schema.table"
+    };
+    // m を取得した状態で呼ぶこと
+    mysqlx::Schema& schemaLocked(mysqlx::Session* session, const std::string& name) {
+        Handles& h = handles[session];
+        auto it = h.schemas.find(name);
+        if(it != h.schemas.end()) {
+            return it->second;
+        }
+        return h.schemas.emplace(name, session->getSchema(name)).first->second;
+    }
+
+    mutable std::mutex                                              m;
+    std::unordered_map<const mysqlx::Session*, Handles>             handles;
+    std::atomic<std::size_t>                                        hits{0};
+    std::atomic<std::size_t>                                        misses{0};
+};
+
+}   // namespace ormx
+
+#endif
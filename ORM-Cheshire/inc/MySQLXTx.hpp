@@ -1,6 +1,7 @@
 #ifndef MYSQLXTX_H_
 #define MYSQLXTX_H_
 
+#include "Debug.hpp"
 #include "RdbTransaction.hpp"
 #include "RdbProcStrategy.hpp"
 #include "/usr/include/mysql-cppconn-8/mysqlx/xdevapi.h"
@@ -13,19 +14,19 @@ public:
     {}
     // ...
     virtual void begin() const override {
-        puts("------ ormx::MySQLXTx::begin()");
+        logger::trace("------ ormx::MySQLXTx::begin()");
         session->startTransaction();
     }
     virtual void commit() const override {
-        puts("------ ormx::MySQLXTx::commit()");
+        logger::trace("------ ormx::MySQLXTx::commit()");
         session->commit();
     }
     virtual void rollback() const override {
-        puts("------ ormx::MySQLXTx::rollback()");
+        logger::trace("------ ormx::MySQLXTx::rollback()");
         session->rollback();
     }
     virtual std::optional<DATA> proc() const override {
-        puts("------ ormx::MySQLXTx::proc()");
+        logger::trace("------ ormx::MySQLXTx::proc()");
         return strategy->proc();
     }
 private:
@@ -5,9 +5,11 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include "Debug.hpp"
 #include "RdbData.hpp"
 #include "DataField.hpp"
 #include "RdbDataStrategy.hpp"
+#include "TableDef.hpp"
 #include "/usr/include/mysql-cppconn-8/mysql/jdbc.h"
 
 class PersonData final : public RdbData {
@@ -15,28 +17,60 @@ private:
     // ダミーとして使うこと
     PersonData();
 public:
-    PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const DataField<int>& _age);
+    /**
+     * person テーブルのスキーマ、全 PersonData で 1 つだけ持つ（行ごとにテーブル名やカラム名の文字列を持たない）。
+     * 中身は TABLE から作る。
+    */
+    struct Schema {
+        std::string       tableName;
+        const ColumnMeta* id;
+        const ColumnMeta* name;
+        const ColumnMeta* email;
+        const ColumnMeta* age;
+    };
+    static const Schema& schema();
+    /**
+     * person テーブルのカラムの宣言、SQL 文とバインド位置はここからコンパイル時に生成する（PersonSql）。
+     * age は nullable なので、値の有無（columnMask）で 2 通りの SQL を持つ。
+    */
+    static constexpr TableDef<4> TABLE{
+        "person"
+      , {{
+            {"id",    "BIGINT",       "AUTO_INCREMENT PRIMARY KEY", true,  false}
+          , {"name",  "VARCHAR(128)", "NOT NULL",                   false, false}
+          , {"email", "VARCHAR(256)", "NOT NULL UNIQUE",            false, false}
+          , {"age",   "INT",          "",                           false, true }
+        }}
+    };
+    static constexpr std::size_t COL_ID = 0, COL_NAME = 1, COL_EMAIL = 2, COL_AGE = 3;      // TABLE の添字
+    std::uint32_t columnMask() const {
+        return age.has_value() ? 1u : 0u;
+    }
 
+    /**
+     * DataField は値で受け取り、メンバへ move する（一時オブジェクトを渡せば、文字列のコピーは発生しない）。
+    */
     PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::size_t>& _id
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const DataField<int>& _age);
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , DataField<int> _age);
 
     PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::size_t>& _id
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , std::optional<DataField<int>>& _age);
+    , DataField<std::size_t> _id
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , DataField<int> _age);
 
     PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const std::optional<DataField<int>>& _age);
+    , DataField<std::size_t> _id
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , std::optional<DataField<int>> _age);
 
+    PersonData(RdbDataStrategy<PersonData>* _strategy
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , std::optional<DataField<int>> _age);
 
     // ..
     static PersonData dummy();
@@ -55,11 +89,11 @@ public:
     virtual std::vector<std::string> getColumns() const override;
     virtual std::vector<std::tuple<std::string, std::string, std::string>> getTableInfo() const override;
 
-    const std::string                     getTableName() const;
-    DataField<std::size_t>                getId() const;
-    DataField<std::string>                getName() const;
-    DataField<std::string>                getEmail() const;
-    std::optional<DataField<int>>         getAge() const;
+    const std::string&                    getTableName() const;
+    const DataField<std::size_t>&         getId() const;
+    const DataField<std::string>&         getName() const;
+    const DataField<std::string>&         getEmail() const;
+    const std::optional<DataField<int>>&  getAge() const;
     RdbDataStrategy<PersonData>*          getDataStrategy() const;
     void                                  setDataStrategy(RdbDataStrategy<PersonData>*);
     // 次の setter メンバ関数には DataField を介さず直接値（DataField::T にあたる value）を設定できた方が便利だが、カプセル化の兼ね合いも悩ましい。
@@ -67,7 +101,6 @@ public:
     void                                  setEmail(DataField<std::string> _email);
     void                                  setAge(DataField<int> _age);
 private:
-    const std::string TABLE_NAME;
     // std::unique_ptr を 単純なデータ構造を保持するクラスに持つと、コピーできないという制限が強すぎて扱いづらくなる。クラス内では raw ポインタの方が都合がいいと思った。
     RdbDataStrategy<PersonData>* strategy;
     DataField<std::size_t> id;          // 必須
@@ -77,34 +110,38 @@ private:
     std::optional<DataField<int>>         age;
 };
 
+// PersonData::TABLE から生成した SQL の定数
+using PersonSql = TableSql<PersonData::TABLE>;
+
 namespace ormx {
 class PersonData {
 private:
     // ダミーとして使うこと
     PersonData();
 public:
+    // 文字列は値で受け取り、メンバへ move する
     PersonData(const std::size_t& _id
-                                , const std::string& _name
-                                , const std::string& _email
+                                , std::string        _name
+                                , std::string        _email
                                 , const int&         _age
     );
     PersonData(const std::size_t& _id
-                            , const std::string& _name
-                            , const std::string& _email
+                            , std::string        _name
+                            , std::string        _email
     );
-    PersonData(const std::string& _name
-                            , const std::string& _email
+    PersonData(std::string        _name
+                            , std::string        _email
                             , const int&         _age
     );
-    PersonData(const std::string& _name
-                            , const std::string& _email
+    PersonData(std::string        _name
+                            , std::string        _email
     );
     // ...
     static ormx::PersonData dummy();
-    std::size_t        getId()    const;
-    std::string        getName()  const;
-    std::string        getEmail() const;
-    std::optional<int> getAge()   const;
+    std::size_t                 getId()    const;
+    const std::string&          getName()  const;
+    const std::string&          getEmail() const;
+    const std::optional<int>&   getAge()   const;
 private:
     std::size_t id;
     std::string name;
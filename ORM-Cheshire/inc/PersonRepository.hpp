@@ -8,8 +8,11 @@
 #include "RdbDataStrategy.hpp"
 #include "PersonStrategy.hpp"
 #include "sql_generator.hpp"
+#include "BulkLoad.hpp"
+#include "MySQLXHandleCache.hpp"
 #include <optional>
 #include <memory>
+#include <algorithm>
 #include "/usr/include/mysql-cppconn-8/mysql/jdbc.h"
 #include "/usr/include/mysql-cppconn-8/mysqlx/xdevapi.h"
 
@@ -17,30 +20,53 @@
  * PersonRepository クラス
  * 
  * PersonData の CRUD を実現する。
+ * insert、update の戻り値は ResultPolicy で選択できる（省略時は従来通り）。
 */
 
 class PersonRepository final : public Repository<PersonData,std::size_t> {
 public:
-    PersonRepository(const MySQLConnection* _con);
+    PersonRepository(const MySQLConnection* _con, const ResultPolicy& _policy = ResultPolicy::DEFAULT);
     // ...
     virtual std::optional<PersonData> insert(const PersonData& data) const override;
     virtual std::optional<PersonData> update(const PersonData& data) const override;
     virtual void remove(const std::size_t& pkey) const override;
     virtual std::optional<PersonData> findOne(const std::size_t& pkey) const;
+    virtual std::vector<std::size_t>  insertMany(std::span<const PersonData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual std::optional<PersonData> upsert(const PersonData& data) const override;
+    virtual void                      upsertMany(std::span<const PersonData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual FindResult<PersonData, std::size_t> findByIds(std::span<const std::size_t> pkeys, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual Cursor<PersonData>        findAll(const std::size_t& fetchSize = DEFAULT_FETCH_SIZE) const override;
+    /**
+     * 移行用の一括ロード（LOAD DATA LOCAL INFILE）、採番されたキーは返さない。前提は mysqlLoadData を参照。
+    */
+    BulkLoadReport bulkLoad(std::span<const PersonData> datas, const std::size_t& chunkRows = 100000) const;
 private:
     const MySQLConnection* con;
+    ResultPolicy policy;
 };
 
 namespace ormx {
+/**
+ * handles を渡した場合、Schema、Table はセッションごとに handles から得る（リポジトリを作り直しても再利用する）。
+ * nullptr の場合はリポジトリごとに 1 回だけ解決する。
+*/
 class PersonRepository final : public Repository<ormx::PersonData, std::size_t> {
 public:
-    PersonRepository(mysqlx::Session* _session);
+    PersonRepository(mysqlx::Session* _session, MySQLXHandleCache* _handles = nullptr);
     virtual std::optional<ormx::PersonData> insert(const ormx::PersonData& data) const override;
     virtual std::optional<ormx::PersonData> update(const ormx::PersonData& data) const override;
     virtual void                            remove(const std::size_t& pkey)      const override;
     virtual std::optional<ormx::PersonData> findOne(const std::size_t& pkey)     const override;
+    virtual std::vector<std::size_t>        insertMany(std::span<const ormx::PersonData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual std::optional<ormx::PersonData> upsert(const ormx::PersonData& data) const override;
+    virtual void                            upsertMany(std::span<const ormx::PersonData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual FindResult<ormx::PersonData, std::size_t> findByIds(std::span<const std::size_t> pkeys, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override;
+    virtual Cursor<ormx::PersonData>        findAll(const std::size_t& fetchSize = DEFAULT_FETCH_SIZE) const override;
 private:
-    mysqlx::Session* session;
+    mysqlx::Table& table() const;
+    mysqlx::Session*                        session;
+    MySQLXHandleCache*                      handles;
+    mutable std::optional<mysqlx::Table>    person;
 };
 
 }   // namespace ormx
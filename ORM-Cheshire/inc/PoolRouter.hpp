@@ -0,0 +1,201 @@
+#ifndef POOLROUTER_H_
+#define POOLROUTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include "Debug.hpp"
+#include "ConnectionPool.hpp"
+
+/**
+ * レプリカの選択方法
+*/
+
+enum class ReplicaSelect {
+    ROUND_ROBIN,    // 順番に
+    LEAST_LOADED    // 貸し出し中が最も少ないもの
+};
+
+/**
+ * RoutingSession クラス
+ *
+ * read-your-writes のための、呼び出し側（利用者、リクエストの系列）ごとの最終書き込み時刻。
+ * 書き込みの直後 window の間は、同じ RoutingSession の読み取りを primary に固定する（レプリカの遅延で古いデータを読まないため）。
+*/
+
+class RoutingSession final {
+public:
+    void markWrite() {
+        lastWrite.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    bool wroteWithin(const std::chrono::milliseconds& window) const {
+        const auto last = lastWrite.load(std::memory_order_relaxed);
+        if(last == NEVER) {
+            return false;
+        }
+        const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(last);
+        return elapsed < window;
+    }
+private:
+    static constexpr std::chrono::steady_clock::rep NEVER = std::numeric_limits<std::chrono::steady_clock::rep>::min();
+    std::atomic<std::chrono::steady_clock::rep> lastWrite{NEVER};
+};
+
+/**
+ * PoolRouter クラス
+ *
+ * 1 つの primary の Pool と N 個のレプリカの Pool を束ね、処理の種類でコネクションの借り先を決める。
+ * 読み取りの拡張はレプリカを増やすことで行い、primary を大きくする必要をなくすためのもの。
+ *
+ * - 読み取り専用の Strategy（RdbProcStrategy::READ_ONLY が true、e.g. MySQLReadStrategy）はレプリカ、それ以外は primary。
+ *   Strategy はコネクションの上に作るものなので、判断は型で行う（borrowFor<STRATEGY>）。
+ * - レプリカが借りられない（空、timeout）場合は、次のレプリカ、最後に primary を試す。
+ * - 書き込みの Route は破棄（返却）時に RoutingSession へ書き込み時刻を記録する。
+ *
+ * e.g.
+ * PoolRouter<sql::Connection> router(&primary, {&replica1, &replica2}, ReplicaSelect::LEAST_LOADED, std::chrono::milliseconds(500));
+ * PoolRouter<sql::Connection>::Route route = router.borrowFor<MySQLReadStrategy<PersonData, std::size_t>>(&session);
+ * MySQLConnection mcon(route.get());
+*/
+
+template <class T>
+class PoolRouter final {
+public:
+    using Lease = typename ConnectionPool<T>::Lease;
+
+    /**
+     * Route クラス
+     *
+     * 借りたコネクション（Lease）と、借り先が primary かどうか。コピーは禁止、ムーブのみ可能。
+    */
+    class Route final {
+    public:
+        Route(Lease&& _lease, const bool& _primary, const bool& _write, RoutingSession* _session)
+        : lease(std::move(_lease)), primary(_primary), write(_write), session(_session)
+        {}
+        ~Route() {
+            release();
+        }
+        Route(const Route&)            = delete;
+        Route& operator=(const Route&) = delete;
+        Route(Route&& own) noexcept: lease(std::move(own.lease)), primary(own.primary), write(own.write), session(own.session) {
+            own.session = nullptr;
+            own.write   = false;
+        }
+        Route& operator=(Route&& own) noexcept {
+            if(this != &own) {
+                release();
+                lease       = std::move(own.lease);
+                primary     = own.primary;
+                write       = own.write;
+                session     = own.session;
+                own.session = nullptr;
+                own.write   = false;
+            }
+            return *this;
+        }
+        T* get() const {
+            return lease.get();
+        }
+        T* operator->() const {
+            return lease.get();
+        }
+        bool isPrimary() const {
+            return primary;
+        }
+        void release() {
+            if(write && session && lease) {
+                session->markWrite();       // 書き込みの完了（返却）時点から window を数える
+            }
+            lease.release();
+            write   = false;
+            session = nullptr;
+        }
+    private:
+        Lease           lease;
+        bool            primary;
+        bool            write;
+        RoutingSession* session;
+    };
+
+    PoolRouter(const ConnectionPool<T>* _primary
+        , std::vector<const ConnectionPool<T>*> _replicas
+        , const ReplicaSelect& _select = ReplicaSelect::ROUND_ROBIN
+        , const std::chrono::milliseconds& _rywWindow = std::chrono::milliseconds(0))
+    : primary(_primary), replicas(std::move(_replicas)), select(_select), rywWindow(_rywWindow)
+    {
+        if(!primary) {
+            throw std::invalid_argument("PoolRouter requires a primary pool.");
+        }
+    }
+    Route borrowWrite(RoutingSession* session = nullptr, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0)) const {
+        return Route(primary->borrow(timeout), true, true, session);
+    }
+    Route borrowRead(RoutingSession* session = nullptr, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0)) const {
+        if(replicas.empty() || (session && rywWindow.count() > 0 && session->wroteWithin(rywWindow))) {
+            pinned.fetch_add(1, std::memory_order_relaxed);
+            return Route(primary->borrow(timeout), true, false, session);
+        }
+        const std::size_t first = pick();
+        for(std::size_t i = 0; i < replicas.size(); i++) {
+            const ConnectionPool<T>* replica = replicas[(first + i) % replicas.size()];
+            try {
+                // 最後のレプリカ以外は待たない、待つのは primary へ逃がす前の 1 回だけ
+                return Route(replica->borrow(i + 1 == replicas.size() ? timeout : std::chrono::milliseconds(0)), false, false, session);
+            } catch(std::exception& e) {
+                logger::debug("PoolRouter replica unavailable: ", e.what());
+            }
+        }
+        fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return Route(primary->borrow(timeout), true, false, session);
+    }
+    template <class STRATEGY>
+    Route borrowFor(RoutingSession* session = nullptr, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0)) const {
+        if constexpr (STRATEGY::READ_ONLY) {
+            return borrowRead(session, timeout);
+        } else {
+            return borrowWrite(session, timeout);
+        }
+    }
+    std::size_t replicaCount() const {
+        return replicas.size();
+    }
+    // RYW で primary に固定した読み取り、レプリカが借りられず primary に逃がした読み取りの回数
+    std::size_t pinnedCount() const {
+        return pinned.load();
+    }
+    std::size_t fallbackCount() const {
+        return fallbacks.load();
+    }
+private:
+    std::size_t pick() const {
+        const std::size_t start = next.fetch_add(1, std::memory_order_relaxed) % replicas.size();
+        if(select == ReplicaSelect::ROUND_ROBIN) {
+            return start;
+        }
+        // 同数の場合に同じレプリカへ偏らないよう、ラウンドロビンの位置から探す
+        std::size_t best = start;
+        std::size_t load = replicas[start]->borrowedCount();
+        for(std::size_t i = 1; i < replicas.size() && load > 0; i++) {
+            const std::size_t idx = (start + i) % replicas.size();
+            const std::size_t l   = replicas[idx]->borrowedCount();
+            if(l < load) {
+                best = idx;
+                load = l;
+            }
+        }
+        return best;
+    }
+
+    const ConnectionPool<T>*                primary;
+    std::vector<const ConnectionPool<T>*>   replicas;
+    const ReplicaSelect                     select;
+    const std::chrono::milliseconds         rywWindow;
+    mutable std::atomic<std::size_t>        next{0};
+    mutable std::atomic<std::size_t>        pinned{0};
+    mutable std::atomic<std::size_t>        fallbacks{0};
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef POOLSTATS_H_
+#define POOLSTATS_H_
+
+#include <array>
+#include <bit>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+/**
+ * PoolStats 構造体
+ *
+ * ConnectionPool の統計のスナップショット。
+ * 時間の単位はすべてマイクロ秒、パーセンタイルはヒストグラムのバケット上限値（概算）。
+ * テストハーネスや FastCGI のフロントエンドから toString() でそのまま出力できるようにしている。
+*/
+
+struct PoolStats {
+    std::uint64_t borrowTotal   = 0;     // 貸し出しの累計
+    std::size_t   borrowCurrent = 0;     // 現在貸し出し中の数
+    std::size_t   borrowPeak    = 0;     // 貸し出し中の最大値
+    std::size_t   idle          = 0;     // 待機中の数
+    std::uint64_t exhaustion    = 0;     // 借りようとした時点で Pool が空だった回数
+    std::uint64_t timeouts      = 0;     // 空のまま timeout した回数
+    std::uint64_t evicted       = 0;     // 保守スレッドが破棄した数
+    std::uint64_t waitP50       = 0;
+    std::uint64_t waitP99       = 0;
+    std::uint64_t waitP999      = 0;
+    std::uint64_t holdCount     = 0;     // Lease で返却された回数（保持時間の標本数）
+    std::uint64_t holdP50       = 0;
+    std::uint64_t holdP99       = 0;
+    std::uint64_t holdP999      = 0;
+
+    std::string toString() const {
+        std::string s;
+        s.append("borrow_total=").append(std::to_string(borrowTotal))
+         .append(" borrow_current=").append(std::to_string(borrowCurrent))
+         .append(" borrow_peak=").append(std::to_string(borrowPeak))
+         .append(" idle=").append(std::to_string(idle))
+         .append(" exhaustion=").append(std::to_string(exhaustion))
+         .append(" timeouts=").append(std::to_string(timeouts))
+         .append(" evicted=").append(std::to_string(evicted))
+         .append(" wait_us_p50=").append(std::to_string(waitP50))
+         .append(" wait_us_p99=").append(std::to_string(waitP99))
+         .append(" wait_us_p999=").append(std::to_string(waitP999))
+         .append(" hold_count=").append(std::to_string(holdCount))
+         .append(" hold_us_p50=").append(std::to_string(holdP50))
+         .append(" hold_us_p99=").append(std::to_string(holdP99))
+         .append(" hold_us_p999=").append(std::to_string(holdP999));
+        return s;
+    }
+};
+
+/**
+ * PoolStatsRecorder クラス
+ *
+ * 記録はスレッドごとのストライプ（キャッシュライン境界に揃えたカウンタ群）に relaxed で加算し、
+ * 読み出し時（snapshot）にだけ全ストライプを集計する。本番で常時有効にしておける程度のコストにするため。
+ *
+ * ヒストグラムは log-linear、2 のべき乗ごとに 8 分割したバケットを持つ（誤差は 12.5% 以内）。
+*/
+
+class PoolStatsRecorder final {
+public:
+    PoolStatsRecorder(): stripes(std::make_unique<Stripe[]>(STRIPES))
+    {}
+    PoolStatsRecorder(const PoolStatsRecorder&)            = delete;
+    PoolStatsRecorder& operator=(const PoolStatsRecorder&) = delete;
+
+    void recordBorrow(const std::chrono::steady_clock::duration& wait) const {
+        Stripe& s = stripe();
+        s.borrows.fetch_add(1, std::memory_order_relaxed);
+        s.wait[bucket(micros(wait))].fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordHold(const std::chrono::steady_clock::duration& hold) const {
+        Stripe& s = stripe();
+        s.holds.fetch_add(1, std::memory_order_relaxed);
+        s.hold[bucket(micros(hold))].fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordExhaustion() const {
+        stripe().exhaustion.fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordTimeout() const {
+        stripe().timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    void recordCurrent(const std::size_t& current) const {
+        std::size_t p = peak.load(std::memory_order_relaxed);
+        while(current > p && !peak.compare_exchange_weak(p, current, std::memory_order_relaxed)) {
+        }
+    }
+    /**
+     * 全ストライプを集計する、borrowCurrent、idle、evicted は Pool 側で埋めること。
+    */
+    PoolStats snapshot() const {
+        PoolStats st;
+        std::array<std::uint64_t, BUCKETS> w{};
+        std::array<std::uint64_t, BUCKETS> h{};
+        for(std::size_t i = 0; i < STRIPES; i++) {
+            const Stripe& s = stripes[i];
+            st.borrowTotal += s.borrows.load(std::memory_order_relaxed);
+            st.holdCount   += s.holds.load(std::memory_order_relaxed);
+            st.exhaustion  += s.exhaustion.load(std::memory_order_relaxed);
+            st.timeouts    += s.timeouts.load(std::memory_order_relaxed);
+            for(std::size_t b = 0; b < BUCKETS; b++) {
+                w[b] += s.wait[b].load(std::memory_order_relaxed);
+                h[b] += s.hold[b].load(std::memory_order_relaxed);
+            }
+        }
+        st.borrowPeak = peak.load(std::memory_order_relaxed);
+        st.waitP50  = percentile(w, 0.50);
+        st.waitP99  = percentile(w, 0.99);
+        st.waitP999 = percentile(w, 0.999);
+        st.holdP50  = percentile(h, 0.50);
+        st.holdP99  = percentile(h, 0.99);
+        st.holdP999 = percentile(h, 0.999);
+        return st;
+    }
+private:
+    static constexpr std::size_t STRIPES    = 8;
+    static constexpr std::size_t LINEAR     = 16;     // 16 未満はそのままの値をバケットにする
+    static constexpr std::size_t SUB_BITS   = 3;      // 2 のべき乗ごとに 8 分割
+    static constexpr std::size_t BUCKETS    = LINEAR + (64 - 4) * (1u << SUB_BITS);
+
+    struct alignas(64) Stripe {
+        std::atomic<std::uint64_t> borrows{0};
+        std::atomic<std::uint64_t> holds{0};
+        std::atomic<std::uint64_t> exhaustion{0};
+        std::atomic<std::uint64_t> timeouts{0};
+        std::array<std::atomic<std::uint64_t>, BUCKETS> wait{};
+        std::array<std::atomic<std::uint64_t>, BUCKETS> hold{};
+    };
+
+    static std::uint64_t micros(const std::chrono::steady_clock::duration& d) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        return us < 0 ? 0 : static_cast<std::uint64_t>(us);
+    }
+    static std::size_t bucket(const std::uint64_t& v) {
+        if(v < LINEAR) {
+            return static_cast<std::size_t>(v);
+        }
+        const std::size_t e   = static_cast<std::size_t>(std::bit_width(v)) - 1;      // floor(log2(v)) >= 4
+        const std::size_t sub = static_cast<std::size_t>(v >> (e - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+        return LINEAR + (e - 4) * (1u << SUB_BITS) + sub;
+    }
+    static std::uint64_t upperBound(const std::size_t& index) {
+        if(index < LINEAR) {
+            return index;
+        }
+        const std::size_t e   = (index - LINEAR) / (1u << SUB_BITS) + 4;
+        const std::size_t sub = (index - LINEAR) % (1u << SUB_BITS);
+        const std::uint64_t lower = (static_cast<std::uint64_t>((1u << SUB_BITS) + sub)) << (e - SUB_BITS);
+        return lower + ((static_cast<std::uint64_t>(1) << (e - SUB_BITS)) - 1);
+    }
+    static std::uint64_t percentile(const std::array<std::uint64_t, BUCKETS>& counts, const double& q) {
+        std::uint64_t total = 0;
+        for(auto c: counts) {
+            total += c;
+        }
+        if(total == 0) {
+            return 0;
+        }
+        const std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for(std::size_t b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if(seen >= rank) {
+                return upperBound(b);
+            }
+        }
+        return upperBound(BUCKETS - 1);
+    }
+    Stripe& stripe() const {
+        static std::atomic<std::size_t> seq{0};
+        thread_local const std::size_t index = seq.fetch_add(1) % STRIPES;
+        return stripes[index];
+    }
+
+    const std::unique_ptr<Stripe[]> stripes;
+    mutable std::atomic<std::size_t> peak{0};
+};
+
+#endif
@@ -15,6 +15,8 @@ class RdbProcStrategy {
 public:
     virtual ~RdbProcStrategy() = default;
     virtual std::optional<DATA> proc() const = 0;
+    // 読み取りのみの処理か、PoolRouter がレプリカに振り分ける判断に使う（派生クラスで true に隠蔽する）
+    static constexpr bool READ_ONLY = false;
 };
 
 #endif
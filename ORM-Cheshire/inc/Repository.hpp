@@ -1,7 +1,40 @@
 #ifndef REPOSITORY_H_
 #define REPOSITORY_H_
 
+#include <span>
+#include <vector>
+#include <utility>
 #include <optional>
+#include <algorithm>
+#include <unordered_map>
+#include "Cursor.hpp"
+
+/**
+ * 書き込み（insert、update）の戻り値の方針
+ *
+ * ホットパスでは結果を返却するための往復（LAST_INSERT_ID、findOne）が書き込みそのものと同じだけ掛かる。
+ * 不要な呼び出し側はこれで省略できるようにする。
+*/
+
+enum class ResultPolicy {
+    DEFAULT,    // 従来通り、insert は採番したキーを設定した入力、update は findOne で再取得したもの
+    NO_ECHO,    // 戻り値を作らない（std::nullopt）、書き込みのみ
+    ECHO,       // 入力をそのまま返却する（insert は採番したキーを設定）、再取得はしない
+    REFETCH     // 書き込んだ行を findOne で再取得して返却する
+};
+
+/**
+ * FindResult 構造体
+ *
+ * findByIds の戻り値、rows は要求したキーと同じ順序（重複したキーにはそれぞれ同じデータ）。
+ * 見つからなかったキーは rows が std::nullopt となり、missing にも（重複を除いて要求順に）格納される。
+*/
+
+template <class DATA, class PKEY>
+struct FindResult {
+    std::vector<std::optional<DATA>> rows;
+    std::vector<PKEY>                missing;
+};
 
 /**
  * リポジトリ基底クラス
@@ -19,6 +52,76 @@ public:
     virtual std::optional<DATA> update(const DATA&)   const = 0;
     virtual void remove(const PKEY&)   const = 0;
     virtual std::optional<DATA> findOne(const PKEY&)  const = 0;
+    /**
+     * 複数行の一括登録、chunkSize 行ごとに 1 つの複数行 INSERT 文（VALUES (...), (...)）を発行する。
+     * 戻り値は採番されたプライマリキ、datas と同じ順序で返却する。
+     * 派生クラスでデフォルト引数を再宣言すること（仮想関数のデフォルト引数は静的な型で決まるため）。
+    */
+    virtual std::vector<PKEY> insertMany(std::span<const DATA> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const = 0;
+    /**
+     * 無ければ登録、あれば更新（upsert）を 1 往復で行う。findOne してから insert / update を選ぶ 2 往復と、その間の競合を無くす。
+     * 戻り値はキーを設定したもの（insert と同じく ResultPolicy に従う）。
+     * MySQL は INSERT ... ON DUPLICATE KEY UPDATE、PostgreSQL は INSERT ... ON CONFLICT DO UPDATE を使う（sql_generator）。
+    */
+    virtual std::optional<DATA> upsert(const DATA&)   const = 0;
+    /**
+     * upsert の一括版、chunkSize 行ごとに 1 つの文を発行する。
+     * 行ごとに登録と更新のどちらになったかはわからない（MySQL では得られない）ので、キーは返さない。
+    */
+    virtual void upsertMany(std::span<const DATA> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const = 0;
+    /**
+     * 複数キーの一括取得、N+1 回の findOne の代わりに IN (?, ?, ...) を chunkSize 個ずつ発行する。
+     * キーの重複は除いて問い合わせる。
+    */
+    virtual FindResult<DATA, PKEY> findByIds(std::span<const PKEY> pkeys, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const = 0;
+    /**
+     * 全件の走査、結果はまとめて取得せず Cursor で 1 行ずつ作る。
+     * fetchSize はドライバに渡す 1 回の取得行数のヒント（対応していないドライバでは無視される）。
+     * Cursor を使い終わるまで、同じコネクションで別の問い合わせを行わないこと。
+    */
+    virtual Cursor<DATA> findAll(const std::size_t& fetchSize = DEFAULT_FETCH_SIZE) const = 0;
+
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1000;
+    static constexpr std::size_t DEFAULT_FETCH_SIZE = 1000;
+protected:
+    /**
+     * findByIds の共通処理、重複を除いたキーを chunkSize 個ずつ fetch に渡し、結果を要求順に並べ直す。
+     * fetch は std::span<const PKEY> を受け取り、見つかった行を std::vector<std::pair<PKEY, DATA>> で返すこと。
+    */
+    template <class Fetch>
+    static FindResult<DATA, PKEY> findByIdsChunked(std::span<const PKEY> pkeys, const std::size_t& chunkSize, Fetch&& fetch) {
+        std::vector<PKEY> unique;
+        unique.reserve(pkeys.size());
+        std::unordered_map<PKEY, std::size_t> position;        // キー -> unique の添字
+        position.reserve(pkeys.size());
+        for(const PKEY& k: pkeys) {
+            if(position.emplace(k, unique.size()).second) {
+                unique.push_back(k);
+            }
+        }
+        std::vector<std::optional<DATA>> found(unique.size());
+        const std::size_t rows = std::max<std::size_t>(1, chunkSize);
+        std::span<const PKEY> all(unique);
+        for(std::size_t offset = 0; offset < all.size(); offset += rows) {
+            for(auto& [k, data]: fetch(all.subspan(offset, std::min(rows, all.size() - offset)))) {
+                auto it = position.find(k);
+                if(it != position.end()) {
+                    found[it->second].emplace(std::move(data));
+                }
+            }
+        }
+        FindResult<DATA, PKEY> result;
+        result.rows.reserve(pkeys.size());
+        for(const PKEY& k: pkeys) {
+            result.rows.push_back(found[position.at(k)]);
+        }
+        for(std::size_t i = 0; i < unique.size(); i++) {
+            if(!found[i].has_value()) {
+                result.missing.push_back(unique[i]);
+            }
+        }
+        return result;
+    }
 };
 
 #endif
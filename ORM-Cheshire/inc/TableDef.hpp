@@ -0,0 +1,230 @@
+#ifndef TABLEDEF_H_
+#define TABLEDEF_H_
+
+#include <array>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+/**
+ * ColumnDef 構造体
+ *
+ * カラムの宣言、RdbData の派生クラスごとに constexpr の配列で持つ。
+ * nullable なカラムは値の有無で SQL が変わるため、その組み合わせ（mask）ごとに SQL を事前に生成する。
+*/
+
+struct ColumnDef {
+    std::string_view name;
+    std::string_view type;
+    std::string_view constraint;
+    bool             pkey     = false;
+    bool             nullable = false;
+};
+
+/**
+ * SqlText 構造体
+ *
+ * コンパイル時に組み立てた SQL 文、固定長のバッファに持つので実行時のメモリ確保は無い。
+ * 容量を超えた場合はコンパイルエラーになる（constexpr の評価中の throw）。
+ *
+ * リポジトリ直下の inc/sql_helper.hpp にも fixed_string による constexpr の SQL 生成があるが、あちらは使わない。
+ * - sql_helper.hpp は ORM-Cheshire の外（インクルードパスに無い）で、識別子を引用符で囲み改行を含む独自の書式を持つ。
+ *   ここで作る SQL は sql_generator.cpp（makeXxxSql）と同じ書式にしている（PersonRepository は両方の SQL を同じ書式で扱う）。
+ * - sql_helper.hpp はカラムをテンプレート引数の並びで受け取る。TableDef は ColumnDef の配列を mask（nullable の有無）で
+ *   選びながら添字で走査するので、長さが mask ごとに変わる文を 1 つの固定長バッファで扱う方が素直に書ける。
+*/
+
+struct SqlText {
+    static constexpr std::size_t CAPACITY = 512;
+    char        data[CAPACITY]{};
+    std::size_t size = 0;
+
+    constexpr SqlText& append(std::string_view s) {
+        if(size + s.size() >= CAPACITY) {
+            throw std::length_error("SqlText capacity exceeded.");
+        }
+        for(char c: s) {
+            data[size++] = c;
+        }
+        return *this;
+    }
+    constexpr std::string_view view() const {
+        return std::string_view(data, size);
+    }
+};
+
+/**
+ * TableDef 構造体
+ *
+ * テーブル名とカラムの宣言。mask は nullable なカラムの有無を宣言順にビットで表したもの
+ * （nullable な 1 番目のカラムに値があれば bit 0 が立つ）。pkey は AUTO_INCREMENT を想定し INSERT には含めない。
+*/
+
+template <std::size_t N>
+struct TableDef {
+    std::string_view             table;
+    std::array<ColumnDef, N>     columns;
+
+    constexpr std::size_t pkeyIndex() const {
+        for(std::size_t i = 0; i < N; i++) {
+            if(columns[i].pkey) {
+                return i;
+            }
+        }
+        throw std::logic_error("TableDef has no primary key.");
+    }
+    constexpr std::size_t nullableCount() const {
+        std::size_t n = 0;
+        for(const ColumnDef& c: columns) {
+            n += c.nullable ? 1 : 0;
+        }
+        return n;
+    }
+    constexpr std::size_t variants() const {
+        return std::size_t(1) << nullableCount();
+    }
+    // mask で値があるとされるカラムか
+    constexpr bool present(const std::size_t& index, const std::uint32_t& mask) const {
+        if(!columns[index].nullable) {
+            return true;
+        }
+        std::size_t bit = 0;
+        for(std::size_t i = 0; i < index; i++) {
+            bit += columns[i].nullable ? 1 : 0;
+        }
+        return (mask >> bit) & 1u;
+    }
+    // INSERT、UPDATE の SET 句でのバインド位置（1 始まり）、含まれないカラムは 0
+    constexpr unsigned int bindIndex(const std::size_t& index, const std::uint32_t& mask) const {
+        if(columns[index].pkey || !present(index, mask)) {
+            return 0;
+        }
+        unsigned int pos = 0;
+        for(std::size_t i = 0; i <= index; i++) {
+            pos += (!columns[i].pkey && present(i, mask)) ? 1 : 0;
+        }
+        return pos;
+    }
+    // UPDATE の WHERE 句の pkey のバインド位置
+    constexpr unsigned int pkeyBindIndex(const std::uint32_t& mask) const {
+        unsigned int pos = 1;
+        for(std::size_t i = 0; i < N; i++) {
+            pos += (!columns[i].pkey && present(i, mask)) ? 1 : 0;
+        }
+        return pos;
+    }
+    /**
+     * pkey を除く、値があるカラム名の一覧（RdbDataStrategy::getColumns 互換）。
+    */
+    std::vector<std::string> columnNames(const std::uint32_t& mask) const {
+        std::vector<std::string> cols;
+        cols.reserve(N);
+        for(std::size_t i = 0; i < N; i++) {
+            if(!columns[i].pkey && present(i, mask)) {
+                cols.emplace_back(columns[i].name);
+            }
+        }
+        return cols;
+    }
+    std::vector<std::tuple<std::string, std::string, std::string>> tableInfo() const {
+        std::vector<std::tuple<std::string, std::string, std::string>> info;
+        info.reserve(N);
+        for(const ColumnDef& c: columns) {
+            info.emplace_back(std::string(c.name), std::string(c.type), std::string(c.constraint));
+        }
+        return info;
+    }
+
+    /**
+     * 以下 SQL の生成、書式は sql_generator.cpp の makeXxxSql と同じ。
+    */
+
+    // INSERT INTO person (name, email, age) VALUES (?, ?, ?)
+    constexpr SqlText insertSql(const std::uint32_t& mask) const {
+        SqlText cols, vals;
+        cols.append("INSERT INTO ").append(table).append(" (");
+        vals.append("VALUES (");
+        bool first = true;
+        for(std::size_t i = 0; i < N; i++) {
+            if(columns[i].pkey || !present(i, mask)) {
+                continue;
+            }
+            cols.append(first ? "" : ", ").append(columns[i].name);
+            vals.append(first ? "?" : ", ?");
+            first = false;
+        }
+        return cols.append(") ").append(vals.view()).append(")");
+    }
+    // UPDATE person SET name = ?, email = ?, age = ? WHERE id = ?
+    constexpr SqlText updateSql(const std::uint32_t& mask) const {
+        SqlText sql;
+        sql.append("UPDATE ").append(table).append(" SET ");
+        bool first = true;
+        for(std::size_t i = 0; i < N; i++) {
+            if(columns[i].pkey || !present(i, mask)) {
+                continue;
+            }
+            sql.append(first ? "" : ", ").append(columns[i].name).append(" = ?");
+            first = false;
+        }
+        return sql.append(" WHERE ").append(columns[pkeyIndex()].name).append(" = ?");
+    }
+    // SELECT id, name, email, age FROM person、すべてのカラムを宣言順に
+    constexpr SqlText findAllSql() const {
+        SqlText sql;
+        sql.append("SELECT ").append(columns[pkeyIndex()].name);
+        for(std::size_t i = 0; i < N; i++) {
+            if(!columns[i].pkey) {
+                sql.append(", ").append(columns[i].name);
+            }
+        }
+        return sql.append(" FROM ").append(table);
+    }
+    // SELECT id, name, email, age FROM person WHERE id = ?
+    constexpr SqlText findOneSql() const {
+        return findAllSql().append(" WHERE ").append(columns[pkeyIndex()].name).append(" = ?");
+    }
+    // DELETE FROM person WHERE id = ?
+    constexpr SqlText deleteSql() const {
+        SqlText sql;
+        return sql.append("DELETE FROM ").append(table).append(" WHERE ").append(columns[pkeyIndex()].name).append(" = ?");
+    }
+};
+
+/**
+ * TableSql 構造体
+ *
+ * TableDef から生成した SQL の定数、DEF は static な constexpr の TableDef を参照すること。
+ * insert、update は mask ごとの組み合わせを持つ。
+*/
+
+template <const auto& DEF>
+struct TableSql {
+    static constexpr std::size_t VARIANTS = DEF.variants();
+
+    static constexpr std::array<SqlText, VARIANTS> makeInsert() {
+        std::array<SqlText, VARIANTS> a{};
+        for(std::uint32_t m = 0; m < VARIANTS; m++) {
+            a[m] = DEF.insertSql(m);
+        }
+        return a;
+    }
+    static constexpr std::array<SqlText, VARIANTS> makeUpdate() {
+        std::array<SqlText, VARIANTS> a{};
+        for(std::uint32_t m = 0; m < VARIANTS; m++) {
+            a[m] = DEF.updateSql(m);
+        }
+        return a;
+    }
+
+    static constexpr std::array<SqlText, VARIANTS> insert  = makeInsert();
+    static constexpr std::array<SqlText, VARIANTS> update  = makeUpdate();
+    static constexpr SqlText                       findOne = DEF.findOneSql();
+    static constexpr SqlText                       findAll = DEF.findAllSql();
+    static constexpr SqlText                       remove  = DEF.deleteSql();
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef TXEXECUTOR_H_
+#define TXEXECUTOR_H_
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include "Debug.hpp"
+#include "ConnectionPool.hpp"
+#include "RdbTransaction.hpp"
+#include "RdbProcStrategy.hpp"
+
+/**
+ * TxExecutor クラス
+ *
+ * RdbTransaction::executeTx を呼び出し側のスレッドではなく、固定数の worker スレッドで実行する。
+ * 独立した複数のトランザクションを同時に投入し、ネットワークの待ち時間を重ねるためのもの。
+ *
+ * - 各 worker は ConnectionPool から 1 つコネクションを借り、worker の終了まで保持する（Lease）。
+ *   トランザクションが例外で終わった場合は ping で生存確認を行い、死んでいれば Lease::discard で破棄して次のタスクで借り直す。
+ *   ping を指定しない場合は生きているものとして保持し続ける（一意制約違反等で健全なコネクションを捨てないため）。
+ *   死んだコネクションから回復させたい場合は ping を指定すること。
+ *   CON と W が異なる場合は、W(CON*) で包んだものを worker ごとに 1 つ作る（e.g. MySQLConnection、ステートメントキャッシュが効く）。
+ * - 投入する処理（Proc）は worker のコネクションを受け取り、その上でリポジトリ、RdbProcStrategy を組み立てて実行する。
+ *   Proc は RdbProcStrategy に包まれ、txFactory が作る RdbTransaction（MySQLTx 等）の executeTx で実行される。
+ * - キューは capacity までで、一杯の場合 submit は空きができるまで待つ（背圧）。
+ * - 戻り値は std::future、あるいは C++20 コルーチンの co_await（再開は worker のスレッドで行われる）。
+ *
+ * e.g.
+ * TxExecutor<PersonData, sql::Connection, MySQLConnection> executor(&app_cp, 4, 64
+ *     , [](MySQLConnection* con, const RdbProcStrategy<PersonData>* s) { return std::make_unique<MySQLTx<PersonData>>(con, s); });
+ * std::future<std::optional<PersonData>> f = executor.submit([data](MySQLConnection* con) {
+ *     PersonRepository repo(con);
+ *     return MySQLCreateStrategy<PersonData, std::size_t>(&repo, data).proc();
+ * });
+*/
+
+template <class DATA, class CON, class W = CON>
+class TxExecutor final {
+public:
+    using Proc      = std::function<std::optional<DATA>(W*)>;
+    using TxFactory = std::function<std::unique_ptr<RdbTransaction<DATA>>(W*, const RdbProcStrategy<DATA>*)>;
+    using Ping      = std::function<bool(CON*)>;
+
+    /**
+     * co_await 用、submit と同じく Proc をキューに積み、完了した worker のスレッドでコルーチンを再開する。
+    */
+    class Awaiter final {
+    public:
+        Awaiter(TxExecutor<DATA, CON, W>* _executor, Proc _proc): executor(_executor), proc(std::move(_proc))
+        {}
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            executor->enqueue(Task{std::move(proc), [this, handle](std::optional<DATA>* data, std::exception_ptr error) {
+                if(error) {
+                    this->error = error;
+                } else {
+                    result.emplace(std::move(*data));
+                }
+                handle.resume();
+            }});
+        }
+        std::optional<DATA> await_resume() {
+            if(error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(*result);
+        }
+    private:
+        TxExecutor<DATA, CON, W>*           executor;
+        Proc                                proc;
+        std::optional<std::optional<DATA>>  result;
+        std::exception_ptr                  error;
+    };
+
+    TxExecutor(const ConnectionPool<CON>* _pool
+        , const std::size_t& _workers
+        , const std::size_t& _capacity
+        , TxFactory _txFactory
+        , const std::chrono::milliseconds& _borrowTimeout = std::chrono::milliseconds(100)
+        , Ping _ping = nullptr)
+    : pool(_pool), capacity(_capacity ? _capacity : 1), txFactory(std::move(_txFactory)), borrowTimeout(_borrowTimeout), ping(std::move(_ping))
+    {
+        const std::size_t n = _workers ? _workers : 1;
+        workers.reserve(n);
+        for(std::size_t i = 0; i < n; i++) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+    TxExecutor(const TxExecutor&)            = delete;
+    TxExecutor& operator=(const TxExecutor&) = delete;
+    /**
+     * キューに残っているものを実行し終えてから終了する。
+    */
+    ~TxExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+        for(std::thread& t: workers) {
+            t.join();
+        }
+    }
+    std::future<std::optional<DATA>> submit(Proc proc) {
+        std::shared_ptr<std::promise<std::optional<DATA>>> promise = std::make_shared<std::promise<std::optional<DATA>>>();
+        std::future<std::optional<DATA>> future = promise->get_future();
+        enqueue(Task{std::move(proc), [promise](std::optional<DATA>* data, std::exception_ptr error) {
+            if(error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(std::move(*data));
+            }
+        }});
+        return future;
+    }
+    Awaiter async(Proc proc) {
+        return Awaiter(this, std::move(proc));
+    }
+    std::size_t workerCount() const {
+        return workers.size();
+    }
+private:
+    struct Task {
+        Proc proc;
+        std::function<void(std::optional<DATA>*, std::exception_ptr)> done;
+    };
+    /**
+     * Proc を RdbTransaction に渡すための RdbProcStrategy。
+    */
+    class ProcStrategy final : public RdbProcStrategy<DATA> {
+    public:
+        ProcStrategy(const Proc* _fn, W* _con): fn(_fn), con(_con)
+        {}
+        virtual std::optional<DATA> proc() const override {
+            return (*fn)(con);
+        }
+    private:
+        const Proc* fn;
+        W* con;
+    };
+
+    void enqueue(Task task) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return stopping || queue.size() < capacity; });
+        if(stopping) {
+            throw std::runtime_error("TxExecutor is stopping.");
+        }
+        queue.push_back(std::move(task));
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+    void run() {
+        typename ConnectionPool<CON>::Lease lease;
+        std::optional<W> wrapper;           // CON と W が異なる場合のみ使う
+        for(;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+                if(queue.empty()) {
+                    return;                 // stopping かつ残りなし
+                }
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            notFull.notify_one();
+            std::optional<DATA> data;
+            std::exception_ptr error;
+            try {
+                if(!lease) {                // 初回、前回の借用に失敗した、あるいは死んだコネクションを破棄した場合
+                    lease = pool->borrow(borrowTimeout);
+                    if constexpr (!std::is_same_v<W, CON>) {
+                        wrapper.emplace(lease.get());
+                    }
+                }
+                W* con = nullptr;
+                if constexpr (std::is_same_v<W, CON>) {
+                    con = lease.get();
+                } else {
+                    con = &*wrapper;
+                }
+                ProcStrategy strategy(&task.proc, con);
+                std::unique_ptr<RdbTransaction<DATA>> tx = txFactory(con, &strategy);
+                data = tx->executeTx();
+            } catch(std::exception& e) {
+                logger::error("TxExecutor: ", e.what());
+                error = std::current_exception();
+            } catch(...) {
+                logger::error("TxExecutor: unknown exception.");
+                error = std::current_exception();     // worker の外に出すと std::terminate になる、future で受け取らせる
+            }
+            if(error && lease && !alive(lease.get())) {
+                wrapper.reset();            // lease のコネクションを参照しているので先に捨てる
+                lease.discard();            // 次のタスクで借り直す
+            }
+            task.done(&data, error);
+        }
+    }
+    bool alive(CON* con) const {
+        if(!ping) {
+            return true;
+        }
+        try {
+            return ping(con);
+        } catch(...) {
+            return false;           // ping の例外は死んでいるものとして扱う
+        }
+    }
+
+    const ConnectionPool<CON>*      pool;
+    const std::size_t               capacity;
+    TxFactory                       txFactory;
+    const std::chrono::milliseconds borrowTimeout;
+    const Ping                      ping;
+    std::mutex                      mutex;
+    std::condition_variable         notEmpty;
+    std::condition_variable         notFull;
+    std::deque<Task>                queue;
+    bool                            stopping = false;
+    std::vector<std::thread>        workers;
+};
+
+#endif
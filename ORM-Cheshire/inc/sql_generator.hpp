@@ -7,9 +7,13 @@
 #include <memory>
 
 std::string makeInsertSql(const std::string& tableName, const std::vector<std::string>& colNames);
+std::string makeInsertSql(const std::string& tableName, const std::vector<std::string>& colNames, const std::size_t& rows);
 std::string makeUpdateSql(const std::string& tableName, const std::string& pkName, const std::vector<std::string>& colNames );
 std::string makeDeleteSql(const std::string& tableName, const std::string& pkName);
 std::string makeFindOneSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames);
+std::string makeFindByIdsSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& keys);
+std::string makeUpsertSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& rows = 1);
+std::string makePgUpsertSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& rows = 1);
 std::string makeCreateTableSql(const std::string& tableName, const std::vector<std::tuple<std::string,std::string,std::string>>& tblInfos);
 
 
@@ -8,7 +8,10 @@
 #include <memory>
 #include <optional>
 #include <set>
+#include <map>
 #include <chrono>
+#include <thread>
+#include <mutex>
 #include "../inc/Debug.hpp"
 #include "../inc/DataField.hpp"
 #include "../inc/RdbDataStrategy.hpp"
@@ -16,14 +19,20 @@
 #include "../inc/PersonData.hpp"
 #include "../inc/MySQLDriver.hpp"
 #include "../inc/ConnectionPool.hpp"
+#include "../inc/PoolRouter.hpp"
 #include "../inc/sql_generator.hpp"
 #include "../inc/PersonRepository.hpp"
+#include "../inc/IdentityMapRepository.hpp"
+#include "../inc/CachedRepository.hpp"
+#include "../inc/IdBlockAllocator.hpp"
+#include "../inc/MySQLXAsyncRepository.hpp"
 #include "../inc/RdbProcStrategy.hpp"
 #include "../inc/MySQLCreateStrategy.hpp"
 #include "../inc/MySQLReadStrategy.hpp"
 #include "../inc/MySQLUpdateStrategy.hpp"
 #include "../inc/MySQLDeleteStrategy.hpp"
 #include "../inc/MySQLTx.hpp"                       // src 相対にしている
+#include "../inc/TxExecutor.hpp"
 #include "../inc/AppProp.hpp"
 #include "/usr/include/mysql-cppconn-8/mysql/jdbc.h"
 #include "/usr/include/mysql-cppconn-8/mysqlx/xdevapi.h"
@@ -32,21 +41,36 @@
 int test_DataField();
 int test_DataField_2();
 int test_DataField_3();
+int test_DataField_meta();
+int test_DataField_move();
 int test_PersonData();
 int test_makeInsertSql();
 int test_makeUpdateSql();
 int test_makeDeleteSql();
 int test_makeFindOneSql();
+int test_makeUpsertSql();
+int test_TableDef();
+int test_bulk_appendRow();
+int test_IdBlockAllocator();
+int test_MySQLXAsyncRepository();
 int test_makeCreateTableSql();
 int test_MySQLDriver();
 
 // int test_mysql_connect();
 int test_ConnectionPool();
+int test_ConnectionPool_borrow();
+int test_ConnectionPool_sharded();
+int test_ConnectionPool_maintenance();
+int test_ConnectionPool_onEvict();
+int test_ConnectionPool_discard();
+int test_ConnectionPool_stats();
+int test_PoolRouter();
 
 // extern    ConnectionPool<sql::Connection> app_cp;
 void mysql_connection_pool(const std::string& server, const std::string& user, const std::string& password, const int& sum);
 int test_mysql_connection_pool_A();
 int test_mysql_connection_pool_B();
+int test_MySQLConnection_statement_cache();
 int test_mysql_connect();
 int test_MySQLTx();
 int test_MySQLTx_rollback();
@@ -54,6 +78,7 @@ int test_MySQLTx_Create(std::size_t* insId);
 int test_MySQLTx_Read(std::size_t* insId);
 int test_MySQLTx_Update(std::size_t* insId);
 int test_MySQLTx_Delete(std::size_t* insId);
+int test_TxExecutor();
 
 int test_mysqlx_connect();
 int test_pqxx_connect();
@@ -65,6 +90,15 @@ int test_PersonRepository_findOne();
 int test_PersonRepository_update();
 int test_PersonRepository_insert();
 int test_PersonRepository_insert_no_age();
+int test_PersonRepository_insertMany();
+int test_PersonRepository_upsert();
+int test_PersonRepository_bulkLoad();
+int test_PersonRepository_ResultPolicy();
+int test_PersonRepository_findByIds();
+int test_PersonRepository_findAll();
 int test_PersonRepository_remove();
+int test_IdentityMapRepository();
+int test_IdentityMapRepository_upsert();
+int test_CachedRepository();
 
 #endif
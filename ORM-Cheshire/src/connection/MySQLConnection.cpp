@@ -6,7 +6,7 @@
 
 void MySQLConnection::begin() const
 {
-    puts("------ MySQLConnection::setAutoCommit");
+    logger::trace("------ MySQLConnection::setAutoCommit");
     try {
         con->setAutoCommit(false);
         // begin_();
@@ -16,7 +16,7 @@ void MySQLConnection::begin() const
 }
 void MySQLConnection::commit() const
 {
-    puts("------ MySQLConnection::commit");
+    logger::trace("------ MySQLConnection::commit");
     try {
         con->commit();
     } catch(std::exception& e) {
@@ -25,7 +25,7 @@ void MySQLConnection::commit() const
 }
 void MySQLConnection::rollback() const
 {
-    puts("------ MySQLConnection::rollback");
+    logger::trace("------ MySQLConnection::rollback");
     try {
         con->rollback();
     } catch(std::exception& e) {
@@ -34,7 +34,7 @@ void MySQLConnection::rollback() const
 }
 sql::PreparedStatement* MySQLConnection::prepareStatement(const std::string& sql) const
 {
-    puts("------ MySQLConnection::prepareStatement");
+    logger::trace("------ MySQLConnection::prepareStatement");
     try {
         return con->prepareStatement(sql);
     } catch(std::exception& e) {
@@ -43,10 +43,38 @@ sql::PreparedStatement* MySQLConnection::prepareStatement(const std::string& sql
 }
 sql::Statement* MySQLConnection::createStatement() const
 {
-    puts("------ MySQLConnection::createStatement");
+    logger::trace("------ MySQLConnection::createStatement");
     try {
         return con->createStatement();
     } catch(std::exception& e) {
         throw std::runtime_error(e.what());
     }
 }
+sql::PreparedStatement* MySQLConnection::prepareCachedStatement(std::string_view sql) const
+{
+    try {
+        auto it = cache.find(sql);
+        if(it != cache.end()) {
+            lru.splice(lru.begin(), lru, it->second);       // 最近使われたものとして先頭に移動する
+            sql::PreparedStatement* prep_stmt = it->second->second.get();
+            prep_stmt->clearParameters();
+            return prep_stmt;
+        }
+        logger::trace("------ MySQLConnection::prepareCachedStatement miss");
+        std::string key(sql);
+        std::unique_ptr<sql::PreparedStatement> prep_stmt(con->prepareStatement(key));
+        while(!lru.empty() && lru.size() >= cacheSize) {
+            cache.erase(lru.back().first);
+            lru.pop_back();                                 // unique_ptr がサーバ側の Statement も閉じる
+        }
+        lru.emplace_front(std::move(key), std::move(prep_stmt));
+        cache.emplace(lru.front().first, lru.begin());      // list の要素は移動しないので、その文字列を指す view をキーにする
+        return lru.front().second.get();
+    } catch(std::exception& e) {
+        throw std::runtime_error(e.what());
+    }
+}
+std::size_t MySQLConnection::cachedStatementCount() const
+{
+    return lru.size();
+}
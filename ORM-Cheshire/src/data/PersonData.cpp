@@ -1,86 +1,89 @@
 #include "../../inc/PersonData.hpp"
 
 PersonData::PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const DataField<int>& _age) 
-    : TABLE_NAME{std::move(std::string("person"))}
-    , strategy{_strategy}, id{std::move(DataField<std::size_t>("id",0))}, name{_name}, email{_email}, age{_age}
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , DataField<int> _age) 
+    : strategy{_strategy}, id{DataField<std::size_t>(schema().id, 0)}, name{std::move(_name)}, email{std::move(_email)}, age{std::move(_age)}
 {
     // 必要ならここで Validation を行う、妥当性検証のオブジェクトをコンポジションして利用するのもあり。
 }
 PersonData::PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::size_t>& _id
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const DataField<int>& _age)
-    : TABLE_NAME{std::move(std::string("person"))}
-    , strategy{_strategy}, id{_id}, name{_name}, email{_email}, age{_age}
+    , DataField<std::size_t> _id
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , DataField<int> _age)
+    : strategy{_strategy}, id{std::move(_id)}, name{std::move(_name)}, email{std::move(_email)}, age{std::move(_age)}
 {
 
 }
 PersonData::PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::size_t>& _id
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , std::optional<DataField<int>>& _age)
-    : TABLE_NAME{std::move(std::string("person"))}
-    , strategy{std::move(_strategy)}, id{_id}, name{_name}, email{_email}, age{_age}
+    , DataField<std::size_t> _id
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , std::optional<DataField<int>> _age)
+    : strategy{_strategy}, id{std::move(_id)}, name{std::move(_name)}, email{std::move(_email)}, age{std::move(_age)}
 {
 }
 
 PersonData::PersonData(RdbDataStrategy<PersonData>* _strategy
-    , const DataField<std::string>& _name
-    , const DataField<std::string>& _email 
-    , const std::optional<DataField<int>>& _age) 
-    : TABLE_NAME{std::move(std::string("person"))}
-    , strategy{_strategy}, id{std::move(DataField<std::size_t>("id",0))}, name{_name}, email{_email}, age{_age}
+    , DataField<std::string> _name
+    , DataField<std::string> _email 
+    , std::optional<DataField<int>> _age) 
+    : strategy{_strategy}, id{DataField<std::size_t>(schema().id, 0)}, name{std::move(_name)}, email{std::move(_email)}, age{std::move(_age)}
 {
     // 必要ならここで Validation を行う、妥当性検証のオブジェクトをコンポジションして利用するのもあり。
 }
 // デフォルトコンストラクタ、ダミーとして使うこと。
 PersonData::PersonData()
-    : TABLE_NAME{std::move(std::string("person"))}
-    , strategy(nullptr)
-    , id(std::move(DataField<std::size_t>("id", 0ul)))
-    , name(std::move(DataField<std::string>("name", "")))
-    , email(std::move(DataField<std::string>("email", "")))
-    , age(std::move(DataField<int>("age", 0)))
+    : strategy(nullptr)
+    , id(DataField<std::size_t>(schema().id, 0ul))
+    , name(DataField<std::string>(schema().name, ""))
+    , email(DataField<std::string>(schema().email, ""))
+    , age(DataField<int>(schema().age, 0))
 {
 }
 
 // ... 
 
+/**
+ * TABLE の宣言から作る、テーブル名とカラム名を書くのは TABLE の 1 箇所だけ。
+ * 型と制約は intern しない（DataField("name", value) で作ったものと同じ ColumnMeta を指すように）。
+*/
+const PersonData::Schema& PersonData::schema() {
+    static const Schema s{
+        std::string(TABLE.table)
+      , internColumnMeta(std::string(TABLE.columns[COL_ID].name))
+      , internColumnMeta(std::string(TABLE.columns[COL_NAME].name))
+      , internColumnMeta(std::string(TABLE.columns[COL_EMAIL].name))
+      , internColumnMeta(std::string(TABLE.columns[COL_AGE].name))
+    };
+    return s;
+}
+
 PersonData PersonData::dummy() {
     return PersonData();
 }
 
+/**
+ * ResultSet から取り出した文字列は、DataField、PersonData のメンバへと move する（カラムあたりの文字列のコピーは取り出しの 1 回だけ）。
+*/
 PersonData PersonData::factory(sql::ResultSet* rs, RdbDataStrategy<PersonData>* strategy) 
 {
-    auto rs_id    = rs->getUInt64(1);
-    auto rs_name  = rs->getString(2);
-    auto rs_email = rs->getString(3);
-    auto rs_age   = rs->getInt(4);
-    DataField<std::size_t> p_id("id", rs_id); 
-    DataField<std::string> p_name("name", rs_name);
-    DataField<std::string> p_email("email", rs_email);
-    std::optional<DataField<int>> p_age(DataField("age", rs_age));
-    PersonData person(strategy, p_id, p_name, p_email, p_age);
-    return person;
+    return PersonData(strategy
+        , DataField<std::size_t>(schema().id, rs->getUInt64(1))              // 行ごとに intern しない
+        , DataField<std::string>(schema().name, std::string(rs->getString(2)))
+        , DataField<std::string>(schema().email, std::string(rs->getString(3)))
+        , std::optional<DataField<int>>(std::in_place, schema().age, rs->getInt(4)));
 }
 
 PersonData PersonData::factoryNoAge(sql::ResultSet* rs, RdbDataStrategy<PersonData>* strategy)
 {
-    auto rs_id    = rs->getUInt64(1);
-    auto rs_name  = rs->getString(2);
-    auto rs_email = rs->getString(3);
-    DataField<std::size_t> p_id("id", rs_id); 
-    DataField<std::string> p_name("name", rs_name);
-    DataField<std::string> p_email("email", rs_email);
-    std::optional<DataField<int>> p_age;
-    PersonData person(strategy, p_id, p_name, p_email, p_age);
-    return person;
-
+    return PersonData(strategy
+        , DataField<std::size_t>(schema().id, rs->getUInt64(1))
+        , DataField<std::string>(schema().name, std::string(rs->getString(2)))
+        , DataField<std::string>(schema().email, std::string(rs->getString(3)))
+        , std::optional<DataField<int>>());
 }
 
 PersonData PersonData::factory(
@@ -89,10 +92,10 @@ PersonData PersonData::factory(
     , int         _age
     , RdbDataStrategy<PersonData>* _strategy)
 {
-    DataField<std::string> df_name("name", _name);
-    DataField<std::string> df_email("email", _email);
-    DataField<int>         df_age("age", _age);
-    return PersonData(_strategy, df_name, df_email, df_age);
+    return PersonData(_strategy
+        , DataField<std::string>(schema().name, std::move(_name))
+        , DataField<std::string>(schema().email, std::move(_email))
+        , DataField<int>(schema().age, _age));
 }
 
 PersonData PersonData::factory(
@@ -100,34 +103,33 @@ PersonData PersonData::factory(
         , std::string _email
         , RdbDataStrategy<PersonData>* _strategy)
 {
-    DataField<std::string> df_name("name", _name);
-    DataField<std::string> df_email("email", _email);
-    std::optional<DataField<int>> df_age;
-    return PersonData(_strategy, df_name, df_email, df_age);
+    return PersonData(_strategy
+        , DataField<std::string>(schema().name, std::move(_name))
+        , DataField<std::string>(schema().email, std::move(_email))
+        , std::optional<DataField<int>>());
 }
 
 
 std::vector<std::string> PersonData::getColumns() const {   // override
-    puts("------ PersonData::getColums");
     return strategy->getColumns(*this);
 }
 
 std::vector<std::tuple<std::string, std::string, std::string>> PersonData::getTableInfo() const { // override
-    puts("------ PersonData::getTableInfo");
+    logger::trace("------ PersonData::getTableInfo");
     return strategy->getTableInfo(*this);
 }
 
 
-const std::string                     PersonData::getTableName()  const { return TABLE_NAME; }
-DataField<std::size_t>                PersonData::getId()         const { return id; }
-DataField<std::string>                PersonData::getName()       const { return name; }
-DataField<std::string>                PersonData::getEmail()      const { return email; }
-std::optional<DataField<int>>         PersonData::getAge()        const { return age; }
+const std::string&                    PersonData::getTableName()  const { return schema().tableName; }
+const DataField<std::size_t>&         PersonData::getId()         const { return id; }
+const DataField<std::string>&         PersonData::getName()       const { return name; }
+const DataField<std::string>&         PersonData::getEmail()      const { return email; }
+const std::optional<DataField<int>>&  PersonData::getAge()        const { return age; }
 RdbDataStrategy<PersonData>*          PersonData::getDataStrategy() const { return strategy; }
 void                                  PersonData::setDataStrategy(RdbDataStrategy<PersonData>* _strategy) { strategy = _strategy; }
-void                                  PersonData::setName(DataField<std::string> _name) { name = _name; }
-void                                  PersonData::setEmail(DataField<std::string> _email) { email = _email; }
-void                                  PersonData::setAge(DataField<int> _age) { age = _age; }
+void                                  PersonData::setName(DataField<std::string> _name) { name = std::move(_name); }
+void                                  PersonData::setEmail(DataField<std::string> _email) { email = std::move(_email); }
+void                                  PersonData::setAge(DataField<int> _age) { age = std::move(_age); }
 
 
 
@@ -137,24 +139,24 @@ void                                  PersonData::setAge(DataField<int> _age) {
 
 
 ormx::PersonData::PersonData(const std::size_t& _id
-                            , const std::string& _name
-                            , const std::string& _email
+                            , std::string        _name
+                            , std::string        _email
                             , const int&         _age
-): id(_id), name(_name), email(_email), age(_age) 
+): id(_id), name(std::move(_name)), email(std::move(_email)), age(_age) 
 {}
 ormx::PersonData::PersonData(const std::size_t& _id
-                            , const std::string& _name
-                            , const std::string& _email
-): id(_id), name(_name), email(_email), age(std::nullopt)
+                            , std::string        _name
+                            , std::string        _email
+): id(_id), name(std::move(_name)), email(std::move(_email)), age(std::nullopt)
 {}
-ormx::PersonData::PersonData(const std::string& _name
-                            , const std::string& _email
+ormx::PersonData::PersonData(std::string        _name
+                            , std::string        _email
                             , const int&         _age
-): name(_name), email(_email), age(_age)
+): name(std::move(_name)), email(std::move(_email)), age(_age)
 {}
-ormx::PersonData::PersonData(const std::string& _name
-                            , const std::string& _email
-): name(_name), email(_email), age(std::nullopt)
+ormx::PersonData::PersonData(std::string        _name
+                            , std::string        _email
+): name(std::move(_name)), email(std::move(_email)), age(std::nullopt)
 {}
 ormx::PersonData::PersonData():
     id(0ul)
@@ -167,7 +169,7 @@ ormx::PersonData::PersonData():
 ormx::PersonData ormx::PersonData::dummy() {
     return ormx::PersonData();
 }
-std::size_t        ormx::PersonData::getId()    const { return id; }
-std::string        ormx::PersonData::getName()  const { return name; }
-std::string        ormx::PersonData::getEmail() const { return email; }
-std::optional<int> ormx::PersonData::getAge()   const { return age; }
+std::size_t                 ormx::PersonData::getId()    const { return id; }
+const std::string&          ormx::PersonData::getName()  const { return name; }
+const std::string&          ormx::PersonData::getEmail() const { return email; }
+const std::optional<int>&   ormx::PersonData::getAge()   const { return age; }
@@ -72,6 +72,8 @@ NG 今この中間ファイルでは正しく動作しない、このコンパ
 #include <set>
 #include <chrono>
 #include <array>
+#include <map>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "Debug.hpp"
 #include "DataField.hpp"
@@ -92,6 +94,11 @@ NG 今この中間ファイルでは正しく動作しない、このコンパ
 #include "MySQLTx.hpp"
 #include "PersonRepository.hpp"
 #include "MySQLXTx.hpp"
+#include "MySQLXGroupCommit.hpp"
+#include "MySQLXHandleCache.hpp"
+#include "MySQLXAsyncRepository.hpp"
+#include "BulkLoad.hpp"
+#include "IdBlockAllocator.hpp"
 #include "MySQLXCreateStrategy.hpp"
 #include "AppProp.hpp"
 #include "mysql/jdbc.h"
@@ -114,6 +121,47 @@ int test_debug_and_error() {
     }
 }
 
+int test_logger() {
+    puts("=== test_logger");
+    std::FILE* fp = nullptr;
+    try {
+        static_assert( !logger::enabled<logger::Level::off> );
+        fp = std::tmpfile();
+        logger::setSink(fp);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; t++) {
+            threads.emplace_back([t] {
+                for(int i = 0; i < 100; i++) {
+                    logger::debug("thread ", t, " i is ", i);
+                }
+            });
+        }
+        for(std::thread& t: threads) {
+            t.join();
+        }
+        logger::flush();
+        std::rewind(fp);
+        int lines = 0;
+        char buf[256];
+        while(std::fgets(buf, sizeof(buf), fp)) {
+            lines++;
+        }
+        logger::setSink(stdout);
+        std::fclose(fp);
+        ptr_lambda_debug<const char*, const int&>("lines is ", lines);
+        // 無効なレベルは 1 行も出力されない、有効な場合はリングに収まる件数なので捨てられない
+        assert( lines == (logger::enabled<logger::Level::debug> ? 400 : 0) );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        logger::setSink(stdout);
+        if(fp) {
+            std::fclose(fp);
+        }
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 
 
 /**
@@ -121,18 +169,60 @@ int test_debug_and_error() {
 */
 
 namespace ormx2 {
+/**
+ * MySQLXStatements クラス
+ *
+ * 1 つのセッション（Repository）の Table と、where を :名前 のプレースホルダで書いた文（TableSelect 等）を保持する。
+ * 同じ文オブジェクトを bind の値だけ変えて再実行すると、コネクタはサーバ側で prepare した文を再利用する。
+ * 文のテキストがキーごとに変わらないので、2 回目以降は解析、実行計画の作成を省ける。
+ * 文は name（DATA の中で一意な名前）で区別し、最初の 1 回だけ make で作る。
+*/
+
+class MySQLXStatements final {
+public:
+    explicit MySQLXStatements(mysqlx::Table* _table): table(_table)
+    {}
+    mysqlx::Table& getTable() const { return *table; }
+    mysqlx::TableSelect& select(const std::string& name, const std::function<mysqlx::TableSelect(mysqlx::Table&)>& make) {
+        return get(selects, name, make);
+    }
+    mysqlx::TableUpdate& update(const std::string& name, const std::function<mysqlx::TableUpdate(mysqlx::Table&)>& make) {
+        return get(updates, name, make);
+    }
+    mysqlx::TableRemove& remove(const std::string& name, const std::function<mysqlx::TableRemove(mysqlx::Table&)>& make) {
+        return get(removes, name, make);
+    }
+private:
+    template <class S>
+    S& get(std::map<std::string, S>& stmts, const std::string& name, const std::function<S(mysqlx::Table&)>& make) {
+        auto it = stmts.find(name);
+        if(it == stmts.end()) {
+            it = stmts.emplace(name, make(*table)).first;
+        }
+        return it->second;
+    }
+    mysqlx::Table*                              table;
+    std::map<std::string, mysqlx::TableSelect>  selects;
+    std::map<std::string, mysqlx::TableUpdate>  updates;
+    std::map<std::string, mysqlx::TableRemove>  removes;
+};
+
 template <class DATA, class PKEY>
 class MySQLXData {
 public:
     virtual ~MySQLXData() = default;
-    virtual DATA insertQuery(mysqlx::Session*)  const = 0;
-    virtual DATA findOneQuery(mysqlx::Session*, const PKEY&) const = 0;
-    virtual DATA updateQuery(mysqlx::Session*)  const = 0;
-    virtual void removeQuery(mysqlx::Session*, const PKEY&)  const = 0;
+    // stmts は Repository が保持するもの（Table は SCHEMA_NAME、TABLE_NAME）、クエリ自身は Schema、Table、文を毎回作らない
+    virtual DATA insertQuery(MySQLXStatements&)  const = 0;
+    virtual DATA findOneQuery(MySQLXStatements&, const PKEY&) const = 0;
+    virtual DATA updateQuery(MySQLXStatements&)  const = 0;
+    virtual void removeQuery(MySQLXStatements&, const PKEY&)  const = 0;
 };
 
 class PersonData final : public MySQLXData<PersonData, std::size_t> {
 public:
+    static constexpr const char* SCHEMA_NAME = "cheshire";
+    static constexpr const char* TABLE_NAME  = "person";
+
     PersonData(const std::size_t& _id
             , const std::string& _name
             , const std::string& _email
@@ -149,12 +239,10 @@ public:
     PersonData(const std::string& _name
             , const std::string& _email ): id(0ul), name(_name), email(_email), age(std::nullopt)
     {}
-    virtual PersonData insertQuery(mysqlx::Session* sess) const override
+    virtual PersonData insertQuery(MySQLXStatements& stmts) const override
     {
-        puts("------ PersonData::insertQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        mysqlx::TableInsert tblIns = person.insert("name", "email", "age");
+        logger::trace("------ PersonData::insertQuery()");
+        mysqlx::TableInsert tblIns = stmts.getTable().insert("name", "email", "age");
         mysqlx::Result res;
         if(age.has_value()) {
             res = tblIns.values(name, email, age.value()).execute();
@@ -167,15 +255,15 @@ public:
         }
         return result;
     }
-    virtual PersonData findOneQuery(mysqlx::Session* sess, const std::size_t& pkey) const override
+    virtual PersonData findOneQuery(MySQLXStatements& stmts, const std::size_t& pkey) const override
     {
-        puts("------ PersonData::findOneQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(pkey));
-
-        mysqlx::RowResult rowRes = person.select("name", "email" , "age").where(cond).execute();
+        logger::trace("------ PersonData::findOneQuery()");
+        mysqlx::TableSelect& select = stmts.select("findOne", [](mysqlx::Table& person) {
+            mysqlx::TableSelect stmt = person.select("name", "email" , "age");
+            stmt.where("id = :id");
+            return stmt;
+        });
+        mysqlx::RowResult rowRes = select.bind("id", pkey).execute();
         std::string r_name;
         std::string r_email;
         std::optional<int> r_age = std::nullopt;
@@ -193,20 +281,26 @@ public:
             return PersonData(pkey, r_name, r_email);
         }
     }
-    virtual PersonData updateQuery(mysqlx::Session* sess) const override
+    virtual PersonData updateQuery(MySQLXStatements& stmts) const override
     {
-        puts("------ PersonData::updateQuery()");
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(id));
-
+        logger::trace("------ PersonData::updateQuery()");
+        // 値もプレースホルダにして、文のテキストを固定する。age が無い場合は age を変更しない別の文
         if(age.has_value()) {
-            person.update().set("name", name).set("email", email).set("age", age.value())
-                    .where(cond).execute();
+            mysqlx::TableUpdate& update = stmts.update("update", [](mysqlx::Table& person) {
+                mysqlx::TableUpdate stmt = person.update();
+                stmt.set("name", mysqlx::expr(":name")).set("email", mysqlx::expr(":email")).set("age", mysqlx::expr(":age"))
+                    .where("id = :id");
+                return stmt;
+            });
+            update.bind("name", name).bind("email", email).bind("age", age.value()).bind("id", id).execute();
         } else {
-            person.update().set("name", name).set("email", email)
-                    .where(cond).execute();
+            mysqlx::TableUpdate& update = stmts.update("updateNoAge", [](mysqlx::Table& person) {
+                mysqlx::TableUpdate stmt = person.update();
+                stmt.set("name", mysqlx::expr(":name")).set("email", mysqlx::expr(":email"))
+                    .where("id = :id");
+                return stmt;
+            });
+            update.bind("name", name).bind("email", email).bind("id", id).execute();
         }
 
         PersonData result(id, name, email);
@@ -215,14 +309,14 @@ public:
         }
         return result;
     }
-    virtual void removeQuery(mysqlx::Session* sess, const std::size_t& pkey)  const override
+    virtual void removeQuery(MySQLXStatements& stmts, const std::size_t& pkey)  const override
     {
-        mysqlx::Schema db = sess->getSchema("cheshire");
-        mysqlx::Table person = db.getTable("person");
-        std::string cond("id = ");
-        cond.append(std::to_string(pkey));
-
-        person.remove().where(cond).execute();
+        mysqlx::TableRemove& remove = stmts.remove("remove", [](mysqlx::Table& person) {
+            mysqlx::TableRemove stmt = person.remove();
+            stmt.where("id = :id");
+            return stmt;
+        });
+        remove.bind("id", pkey).execute();
     }
 
     /**
@@ -258,31 +352,36 @@ public:
 template<class DATA, class PKEY>
 class MySQLXBasicRepository final : public Repository<DATA, PKEY> {
 public:
-    MySQLXBasicRepository(mysqlx::Session* _session, const DATA& _data): session(_session), d(_data)
+    /**
+     * handles を渡した場合、Table はセッションごとに handles から得る（リポジトリを作り直しても再利用する）。
+     * nullptr の場合はリポジトリごとに 1 回だけ解決する。
+    */
+    MySQLXBasicRepository(mysqlx::Session* _session, const DATA& _data, ormx::MySQLXHandleCache* _handles = nullptr)
+    : session(_session), d(_data), handles(_handles)
     {}
     virtual DATA insert(const DATA& data)  const
     {
-        puts("------ MySQLXBasicRepository::insert()");
+        logger::trace("------ MySQLXBasicRepository::insert()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&data);
-        return pdata->insertQuery(session);
+        return pdata->insertQuery(statements());
     }
     virtual DATA update(const DATA& data)  const
     {
-        puts("------ MySQLXBasicRepository::update()");
+        logger::trace("------ MySQLXBasicRepository::update()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&data);
-        return pdata->updateQuery(session);
+        return pdata->updateQuery(statements());
     }
     virtual DATA findOne(const PKEY& pkey) const
     {
-        puts("------ MySQLXBasicRepository::findOne()");
+        logger::trace("------ MySQLXBasicRepository::findOne()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&d);
-        return pdata->findOneQuery(session, pkey);
+        return pdata->findOneQuery(statements(), pkey);
     }
     virtual void remove(const PKEY& pkey) const
     {
-        puts("------ MySQLXBasicRepository::remove()");
+        logger::trace("------ MySQLXBasicRepository::remove()");
         const MySQLXData<DATA, PKEY>* pdata = static_cast<const DATA*>(&d);
-        return pdata->removeQuery(session, pkey);
+        return pdata->removeQuery(statements(), pkey);
     }
     /**
      * 単なるテンプレート型に過ぎない DATA をどのようにインスタンス化するのか。
@@ -302,8 +401,23 @@ public:
     */
 
 private:
-    mysqlx::Session* session;
-    DATA d;
+    MySQLXStatements& statements() const
+    {
+        if(!stmts.has_value()) {
+            if(handles) {
+                stmts.emplace(&handles->table(session, DATA::SCHEMA_NAME, DATA::TABLE_NAME));
+            } else {
+                tbl.emplace(session->getSchema(DATA::SCHEMA_NAME).getTable(DATA::TABLE_NAME));
+                stmts.emplace(&tbl.value());
+            }
+        }
+        return stmts.value();
+    }
+    mysqlx::Session*                            session;
+    DATA                                        d;
+    ormx::MySQLXHandleCache*                    handles;
+    mutable std::optional<mysqlx::Table>        tbl;
+    mutable std::optional<MySQLXStatements>     stmts;     // 文はリポジトリ（= 1 つのセッション）ごとに再利用する
 };
 
 }   // namespace ormx2
@@ -312,7 +426,7 @@ private:
 
 
 
-ConnectionPool<sql::Connection> app_cp;
+ConnectionPool<sql::Connection> app_cp("sql::Connection.", 0);     // 0 は CPU 数分のシャード
 AppProp appProp;
 
 bool read_app_prop() {
@@ -423,7 +537,22 @@ int test_read_appProp() {
  * sql::Connection ではなく mysqlx::Session をプールするものが必要。
 */
 
-ConnectionPool<mysqlx::Session> app_sp("mysqlx::Session.");     // アプリケーションのセッションプール
+ormx::MySQLXHandleCache app_xh;    // セッションごとの Schema、Table のキャッシュ、app_sp の破棄（evict）で捨てるので app_sp より先に定義する
+ConnectionPool<mysqlx::Session> app_sp("mysqlx::Session.", 0);  // アプリケーションのセッションプール、0 は CPU 数分のシャード
+
+/**
+ * セッションの生存確認、サーバ側のタイムアウト等で切断されていれば false となる。
+ * 保守スレッドから呼ばれるので、利用者のリクエストがこのコストを払うことはない。
+*/
+bool mysqlx_session_ping(mysqlx::Session* sess) {
+    try {
+        sess->sql("SELECT 1").execute();
+        return true;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return false;
+    }
+}
 
 void mysqlx_session_pool(const std::string& server, const int& port, const std::string& user, const std::string& passwd, const int& sum) {
     puts("=== mysqlx_session_pool");
@@ -431,6 +560,12 @@ void mysqlx_session_pool(const std::string& server, const int& port, const std::
         puts("connected ... ");
         app_sp.push(new mysqlx::Session(server, port, user, passwd));
     }
+    // 死んだセッションの破棄と sum までの補充は保守スレッドに任せる。
+    app_sp.onEvict([](const mysqlx::Session* sess) { app_xh.invalidate(sess); });
+    app_sp.startMaintenance(mysqlx_session_ping
+                        , [server, port, user, passwd]{ return new mysqlx::Session(server, port, user, passwd); }
+                        , static_cast<std::size_t>(sum)
+                        , std::chrono::seconds(30));
 }
 
 int test_mysqlx_session_pool() {
@@ -600,8 +735,10 @@ int test_ormx_PersonRepository_insert() {
     puts("=== test_ormx_PersonRepository_insert");
     // TODO セッションはプールしたものを利用すること
     // mysqlx::Session session("localhost", 33060, "derek", "derek1234");
-    mysqlx::Session* session = app_sp.pop();
     try {
+        // 例外の経路でもセッションが Pool に返却されるよう Lease を利用する。
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        mysqlx::Session* session = lease.get();
         std::string expect_name("Major");
         std::string expect_email("major@loki.org");
         int         expect_age = 24;
@@ -627,7 +764,122 @@ int test_ormx_PersonRepository_insert() {
             assert(result_2.value().getEmail()       == expect_email_2);
             assert(result_2.value().getAge().has_value() == 0);
         }
-        app_sp.push(session);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ormx_PersonRepository_insertMany() {
+    puts("=== test_ormx_PersonRepository_insertMany");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        std::vector<ormx::PersonData> datas;
+        datas.emplace_back("Togusa", "togusa_" + suffix + "@loki.org", 30);
+        datas.emplace_back("Ishikawa", "ishikawa_" + suffix + "@loki.org");
+        datas.emplace_back("Saito", "saito_" + suffix + "@loki.org", 35);
+        ormx::PersonRepository repo(lease.get());
+        std::vector<std::size_t> keys = repo.insertMany(datas, 2);
+        assert(keys.size() == datas.size());
+        assert(keys[1] == keys[0] + 1);     // 同じチャンク内は連番
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ormx_PersonRepository_handles() {
+    puts("=== test_ormx_PersonRepository_handles");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        const std::size_t misses = app_xh.missCount();
+        for(int i = 0; i < 3; i++) {
+            // リポジトリを作り直しても、同じセッションの Table は作らない
+            ormx::PersonRepository repo(lease.get(), &app_xh);
+            std::optional<ormx::PersonData> result = repo.insert(ormx::PersonData("Kusanagi", "kusanagi_" + std::to_string(i) + "_" + suffix + "@loki.org", 30));
+            assert( result.has_value() == 1 );
+        }
+        ptr_lambda_debug<const char*, const std::size_t&>("hit count is ", app_xh.hitCount());
+        assert( app_xh.missCount() - misses <= 1 );
+        app_xh.invalidate(lease.get());
+        ormx::PersonRepository repo(lease.get(), &app_xh);
+        assert( repo.insertMany(std::vector<ormx::PersonData>{ormx::PersonData("Batou", "batou_" + suffix + "@loki.org")}).size() == 1 );
+        assert( app_xh.missCount() - misses <= 2 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ormx_PersonRepository_async() {
+    puts("=== test_ormx_PersonRepository_async");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        ormx::PersonRepository repo(lease.get(), &app_xh);
+        ormx::MySQLXAsyncRepository<ormx::PersonRepository> async(&repo);
+        // 独立した複数の文を、結果を待たずに積む
+        std::future<std::optional<ormx::PersonData>> f1 = async.insert(ormx::PersonData("Motoko", "motoko_" + suffix + "@loki.org", 28));
+        std::future<std::optional<ormx::PersonData>> f2 = async.insert(ormx::PersonData("Tachikoma", "tachikoma_" + suffix + "@loki.org"));
+        std::future<std::vector<std::size_t>> f3 = async.insertMany(std::vector<ormx::PersonData>{
+            ormx::PersonData("Borma", "borma_" + suffix + "@loki.org", 40), ormx::PersonData("Paz", "paz_" + suffix + "@loki.org")
+        });
+        async.flush();
+        assert( f1.get().has_value() == true );
+        assert( f2.get().has_value() == true );
+        std::vector<std::size_t> keys = f3.get();
+        FindResult<ormx::PersonData, std::size_t> found = async.findByIds(keys).get();
+        assert( found.missing.empty() );
+        assert( found.rows[0].value().getName() == "Borma" );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ormx_PersonRepository_findByIds() {
+    puts("=== test_ormx_PersonRepository_findByIds");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        std::vector<ormx::PersonData> datas;
+        datas.emplace_back("Aramaki", "aramaki_" + suffix + "@loki.org", 60);
+        datas.emplace_back("Pazu", "pazu_" + suffix + "@loki.org");
+        ormx::PersonRepository repo(lease.get());
+        std::vector<std::size_t> keys = repo.insertMany(datas);
+        std::vector<std::size_t> pkeys = {keys[1], 0, keys[0]};
+        FindResult<ormx::PersonData, std::size_t> result = repo.findByIds(pkeys);
+        assert(result.rows.size() == 3);
+        assert(result.rows[0].has_value() == true && result.rows[0].value().getName() == "Pazu");
+        assert(result.rows[0].value().getAge().has_value() == false);
+        assert(result.rows[1].has_value() == false);
+        assert(result.rows[2].has_value() == true && result.rows[2].value().getAge().value() == 60);
+        assert(result.missing.size() == 1);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ormx_PersonRepository_findAll() {
+    puts("=== test_ormx_PersonRepository_findAll");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        ormx::PersonRepository repo(lease.get());
+        std::size_t count = 0;
+        for(const ormx::PersonData& p: repo.findAll()) {
+            assert(p.getId() > 0);
+            count++;
+        }
+        ptr_lambda_debug<const char*, const std::size_t&>("count is ", count);
+        assert(count > 0);
         return EXIT_SUCCESS;
     } catch(std::exception& e) {
         ptr_print_error<const decltype(e)&>(e);
@@ -639,8 +891,10 @@ int test_MySQLXCreateStrategy() {
     puts("=== test_MySQLXCreateStrategy");
     // TODO セッションはプールしたものを利用すること
     // mysqlx::Session session("localhost", 33060, "derek", "derek1234");
-    mysqlx::Session* session = app_sp.pop();
     try {
+        // 例外の経路でもセッションが Pool に返却されるよう Lease を利用する。
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        mysqlx::Session* session = lease.get();
         std::string expect_name("Togusa");
         std::string expect_email("togusa@loki.org");
         int         expect_age = 36;
@@ -655,7 +909,6 @@ int test_MySQLXCreateStrategy() {
             assert(result.value().getEmail()       == expect_email);
             assert(result.value().getAge().value() == expect_age);
         }
-        app_sp.push(session);
         return EXIT_SUCCESS;
     } catch(std::exception& e) {
         ptr_print_error<const decltype(e)&>(e);
@@ -667,6 +920,56 @@ int test_MySQLXCreateStrategy() {
     */
 }
 
+int test_MySQLXGroupCommit() {
+    puts("=== test_MySQLXGroupCommit");
+    try {
+        ConnectionPool<mysqlx::Session>::Lease lease = app_sp.borrow(std::chrono::milliseconds(100));
+        const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        std::clock_t start = clock();
+        std::vector<std::size_t> ids;
+        std::shared_ptr<Repository<ormx::PersonData, std::size_t>> repo = std::make_shared<ormx::PersonRepository>(lease.get());
+        {
+            // 20 件を 8 件、2 ミリ秒の窓でまとめる
+            ormx::MySQLXGroupCommit<ormx::PersonData> gc(lease.get(), 8, std::chrono::milliseconds(2));
+            std::vector<std::future<std::optional<ormx::PersonData>>> futures;
+            for(int i = 0; i < 20; i++) {
+                ormx::PersonData data("Group" + std::to_string(i), "group" + std::to_string(i) + "_" + suffix + "@commit.org", 20 + i);
+                futures.push_back(gc.submit(std::make_shared<ormx::MySQLXCreateStrategy<ormx::PersonData, std::size_t>>(repo.get(), data)));
+            }
+            // 一意制約に抵触する 1 件は、それだけが失敗する
+            std::future<std::optional<ormx::PersonData>> dup = gc.submit([repo, suffix](mysqlx::Session*) {
+                return repo->insert(ormx::PersonData("GroupDup", "group0_" + suffix + "@commit.org", 99));
+            });
+            for(std::size_t i = 0; i < futures.size(); i++) {
+                std::optional<ormx::PersonData> result = futures[i].get();
+                assert( result.has_value() );
+                assert( result.value().getName() == "Group" + std::to_string(i) );
+                ids.push_back(result.value().getId());
+            }
+            bool thrown = false;
+            try {
+                dup.get();
+            } catch(std::exception& e) {
+                thrown = true;
+            }
+            assert( thrown );
+            ptr_lambda_debug<const char*, const std::size_t&>("batchCount is ", gc.batchCount());
+            ptr_lambda_debug<const char*, const std::size_t&>("retryCount is ", gc.retryCount());
+            assert( gc.batchCount() < futures.size() );         // 1 件ずつのコミットより少ない
+        }
+        // 後始末、ormx::PersonRepository::remove は未実装なので SQL で消す
+        for(const std::size_t& id: ids) {
+            lease->sql("DELETE FROM person WHERE id = ?").bind(id).execute();
+        }
+        std::clock_t end = clock();
+        std::cout << "passed " << (double)(end-start)/CLOCKS_PER_SEC << " sec." << std::endl;
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 /**
  * libpqxx や X DevAPI はコネクションプールの仕組みは利用できても、先に設計した、トランザクションの仕組みは利用できないと感じた。
  * （使ってもいいが、いらないという意味）Too Much なものになってしまうから。
@@ -807,12 +1110,13 @@ int test_pqxx_rollback() {
 
 class CompanyData {
 public:
-    CompanyData(const long& _id, const std::string& _name, const std::string& _address) : id(_id), name(_name), address(_address)
+    // 文字列は値で受け取り、メンバへ move する
+    CompanyData(const long& _id, std::string _name, std::string _address) : id(_id), name(std::move(_name)), address(std::move(_address))
     {}
     // ...
     long getId()      const { return id; }
-    std::string getName()    const { return name; }
-    std::string getAddress() const { return address; }
+    const std::string& getName()    const { return name; }
+    const std::string& getAddress() const { return address; }
 private:
     long id;
     std::string name;
@@ -820,26 +1124,73 @@ private:
 };
 
 
+/**
+ * PostgreSQL の一括ロード、COPY（pqxx::stream_to）を使う。
+ * 1 回の COPY で rows をすべて流し込む、行ごとの往復、SQL の解析は無くサーバ側に残るのは制約の検査だけになる。
+ * COPY の間、同じトランザクションで別の問い合わせはできない。
+*/
+
+template <std::ranges::input_range R, class DATA, class... Getters>
+BulkLoadReport pgsqlCopy(pqxx::work* tx, const BulkDescriptor<DATA, Getters...>& desc, R&& rows)
+{
+    logger::trace("------ pgsqlCopy table is ", desc.table);
+    const auto start = std::chrono::steady_clock::now();
+    BulkLoadReport report;
+    pqxx::stream_to stream = std::apply([&](const auto&... c) {
+        return pqxx::stream_to::table(*tx, {desc.table}, {c...});
+    }, desc.columns);
+    for(const DATA& data: rows) {
+        std::apply([&](const auto&... get) { stream.write_values(get(data)...); }, desc.getters);
+        report.rows++;
+    }
+    stream.complete();
+    report.batches = 1;
+    report.elapsed = std::chrono::steady_clock::now() - start;
+    return report;
+}
+
+
+/**
+ * IdBlockAllocator の予約に使う、PostgreSQL のシーケンスから n 個のキーを 1 往復で取得する関数。
+ * 呼び出し側のトランザクションとは別の、専用のコネクションを持つ（予約は IdBlockAllocator のスレッドで行われる）。
+*/
+
+IdBlockAllocator<long>::Reserve pgsqlSequenceReserve(const std::string& conninfo, const std::string& sequence)
+{
+    auto con = std::make_shared<pqxx::connection>(conninfo);
+    return [con, sequence](const std::size_t& n) {
+        logger::trace("------ pgsqlSequenceReserve sequence is ", sequence);
+        pqxx::nontransaction tx{*con};
+        std::vector<long> ids;
+        ids.reserve(n);
+        for(const pqxx::row& r: tx.exec_params("SELECT nextval($1) FROM generate_series(1, $2)", sequence, static_cast<long>(n))) {
+            ids.push_back(r[0].as<long>());
+        }
+        return ids;
+    };
+}
+
+
 // Repository の派生クラス
 
 class CompanyRepository final : public Repository<CompanyData, long> {
 public:
-    CompanyRepository(pqxx::work* _tx): tx(_tx)
+    /**
+     * ids を渡した場合、キーはそこから払い出す（insert が 1 往復になる）。nullptr の場合は insert ごとに nextval を問い合わせる。
+    */
+    CompanyRepository(pqxx::work* _tx, IdBlockAllocator<long>* _ids = nullptr): tx(_tx), ids(_ids)
     {}
     virtual std::optional<CompanyData> insert(const CompanyData& data)   const override
     {
         // 実装
-        puts("------ CompanyRepository::insert()");
-        // 次のクエリは 今後、DRY の原則に引っかかると思われる。
-        long nextId = tx->query_value<long>(
+        logger::trace("------ CompanyRepository::insert()");
+        long nextId = ids ? ids->next() : tx->query_value<long>(
             "SELECT nextval('table_id_seq')"
         );
-        std::string sql("INSERT INTO company (id, name, address) values (");
-        sql.append(std::to_string(nextId)).append(", '").append(data.getName()).append("', '").append(data.getAddress()).append("')");
-        ptr_lambda_debug<const char*, const std::string&>("sql: ", sql);
-        tx->exec0(sql);
-        CompanyData result(nextId, data.getName(), data.getAddress());
-        return result;
+        static const std::string sql("INSERT INTO company (id, name, address) VALUES ($1, $2, $3)");       // 値は文字列に埋め込まずパラメータで渡す
+        logger::debug("sql: ", sql);
+        tx->exec_params0(sql, nextId, data.getName(), data.getAddress());
+        return std::optional<CompanyData>(std::in_place, nextId, data.getName(), data.getAddress());     // 戻り値の中に直接作る
     }
     virtual std::optional<CompanyData> update(const CompanyData&)   const override
     {
@@ -855,8 +1206,176 @@ public:
         // TODO 実装
         return std::nullopt;
     }
+    /**
+     * 複数行の一括登録。
+     * キーはチャンクごとにまとめて採番し（nextIds）、
+     * VALUES ($1, $2, $3), ($4, $5, $6), ... の 1 文をパラメータ付きで実行する。
+    */
+    virtual std::vector<long> insertMany(std::span<const CompanyData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override
+    {
+        logger::trace("------ CompanyRepository::insertMany()");
+        std::vector<long> keys;
+        keys.reserve(datas.size());
+        const std::size_t rows = std::max<std::size_t>(1, std::min<std::size_t>(chunkSize, 65535 / 3));     // プレースホルダの上限
+        for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+            std::span<const CompanyData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+            const std::vector<long> chunkKeys = nextIds(chunk.size());
+            std::string sql("INSERT INTO company (id, name, address) VALUES ");
+            pqxx::params params;
+            params.reserve(chunk.size() * 3);
+            for(std::size_t i = 0; i < chunk.size(); i++) {
+                const long id = chunkKeys[i];
+                sql.append(i ? ", " : "").append("($").append(std::to_string(i * 3 + 1))
+                   .append(", $").append(std::to_string(i * 3 + 2)).append(", $").append(std::to_string(i * 3 + 3)).append(")");
+                params.append(id);
+                params.append(chunk[i].getName());
+                params.append(chunk[i].getAddress());
+                keys.push_back(id);
+            }
+            tx->exec_params0(sql, params);
+        }
+        return keys;
+    }
+    /**
+     * upsert、INSERT ... ON CONFLICT (id) DO UPDATE を 1 回発行する（SQL は makePgUpsertSql）。
+     * id が 0 の場合は新規としてキーを採番する（nextIds）、それ以外はそのキーの行が無ければ登録、あれば更新する。
+    */
+    virtual std::optional<CompanyData> upsert(const CompanyData& data) const override
+    {
+        logger::trace("------ CompanyRepository::upsert()");
+        static const std::string sql = makePgUpsertSql("company", "id", {"name", "address"});
+        logger::debug("sql: ", sql);
+        const long id = data.getId() ? data.getId() : nextIds(1).at(0);
+        tx->exec_params0(sql, id, data.getName(), data.getAddress());
+        return std::optional<CompanyData>(std::in_place, id, data.getName(), data.getAddress());
+    }
+    /**
+     * 複数行の upsert、チャンクごとに 1 文。id が 0 の行のキーはチャンクごとにまとめて採番する。
+     * 同じキーの行を 1 つのチャンクに含めないこと（PostgreSQL の制約、makePgUpsertSql を参照）。
+    */
+    virtual void upsertMany(std::span<const CompanyData> datas, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override
+    {
+        logger::trace("------ CompanyRepository::upsertMany()");
+        const std::size_t rows = std::max<std::size_t>(1, std::min<std::size_t>(chunkSize, 65535 / 3));     // プレースホルダの上限
+        for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+            std::span<const CompanyData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+            const std::size_t fresh = std::count_if(chunk.begin(), chunk.end(), [](const CompanyData& d) { return d.getId() == 0; });
+            const std::vector<long> freshIds = fresh ? nextIds(fresh) : std::vector<long>();
+            std::size_t next = 0;
+            pqxx::params params;
+            params.reserve(chunk.size() * 3);
+            for(const CompanyData& data: chunk) {
+                params.append(data.getId() ? data.getId() : freshIds.at(next++));
+                params.append(data.getName());
+                params.append(data.getAddress());
+            }
+            tx->exec_params0(makePgUpsertSql("company", "id", {"name", "address"}, chunk.size()), params);
+        }
+    }
+    /**
+     * 複数キーの一括取得、WHERE id IN ($1, $2, ...) をチャンクごとに 1 回発行する。
+    */
+    virtual FindResult<CompanyData, long> findByIds(std::span<const long> pkeys, const std::size_t& chunkSize = DEFAULT_CHUNK_SIZE) const override
+    {
+        logger::trace("------ CompanyRepository::findByIds()");
+        return findByIdsChunked(pkeys, std::min<std::size_t>(chunkSize, 65535), [this](std::span<const long> chunk) {
+            std::string sql("SELECT id, name, address FROM company WHERE id IN (");
+            pqxx::params params;
+            params.reserve(chunk.size());
+            for(std::size_t i = 0; i < chunk.size(); i++) {
+                sql.append(i ? ", $" : "$").append(std::to_string(i + 1));
+                params.append(chunk[i]);
+            }
+            sql.append(")");
+            std::vector<std::pair<long, CompanyData>> rows;
+            rows.reserve(chunk.size());
+            for(const pqxx::row& r: tx->exec_params(sql, params)) {
+                const long id = r[0].as<long>();
+                rows.emplace_back(id, CompanyData(id, r[1].as<std::string>(), r[2].as<std::string>()));
+            }
+            return rows;
+        });
+    }
+    /**
+     * 全件の走査、pqxx::result は結果をすべてクライアントに持つため、サーバ側カーソル（icursorstream）を使い
+     * fetchSize 行ずつ取り出す。カーソルはトランザクション（tx）の中でのみ有効。
+    */
+    virtual Cursor<CompanyData> findAll(const std::size_t& fetchSize = DEFAULT_FETCH_SIZE) const override
+    {
+        logger::trace("------ CompanyRepository::findAll()");
+        struct State {
+            State(pqxx::work& tx, const long& stride): stream(tx, "SELECT id, name, address FROM company", "company_cursor", stride)
+            {}
+            pqxx::icursorstream     stream;         // コピー、ムーブ不可なので shared_ptr の中に直接作る
+            pqxx::result            rows;
+            pqxx::result::size_type pos = 0;
+        };
+        std::shared_ptr<State> st = std::make_shared<State>(*tx, static_cast<long>(std::max<std::size_t>(1, fetchSize)));
+        return Cursor<CompanyData>([st]() -> std::optional<CompanyData> {
+            if(st->pos >= st->rows.size()) {
+                st->stream >> st->rows;         // 次の fetchSize 行を取得する
+                st->pos = 0;
+                if(st->rows.empty()) {
+                    return std::nullopt;
+                }
+            }
+            const pqxx::row r = st->rows[st->pos++];
+            return CompanyData(r[0].as<long>(), r[1].as<std::string>(), r[2].as<std::string>());
+        });
+    }
+    /**
+     * 移行用の一括ロード、chunkRows 行ごとにキーをまとめて採番し（nextIds）、COPY で流し込む。
+     * 採番したキーは datas と同じ順序で keys に返す（nullptr の場合は返さない）。
+    */
+    BulkLoadReport bulkLoad(std::span<const CompanyData> datas, const std::size_t& chunkRows = 100000, std::vector<long>* keys = nullptr) const
+    {
+        logger::trace("------ CompanyRepository::bulkLoad()");
+        struct Keyed {
+            long               id;
+            const CompanyData* data;
+        };
+        static const auto desc = makeBulkDescriptor<Keyed>("company", {"id", "name", "address"}
+            , [](const Keyed& k) { return k.id; }
+            , [](const Keyed& k) -> const std::string& { return k.data->getName(); }
+            , [](const Keyed& k) -> const std::string& { return k.data->getAddress(); });
+        const auto start = std::chrono::steady_clock::now();
+        BulkLoadReport report;
+        const std::size_t rows = std::max<std::size_t>(1, chunkRows);
+        for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+            std::span<const CompanyData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+            const std::vector<long> chunkKeys = nextIds(chunk.size());
+            auto keyed = std::views::iota(std::size_t(0), chunk.size()) | std::views::transform([&](const std::size_t& i) {
+                return Keyed{chunkKeys[i], &chunk[i]};
+            });
+            const BulkLoadReport r = pgsqlCopy(tx, desc, keyed);
+            report.rows += r.rows;
+            report.batches++;
+            if(keys) {
+                keys->insert(keys->end(), chunkKeys.begin(), chunkKeys.end());
+            }
+        }
+        report.elapsed = std::chrono::steady_clock::now() - start;
+        logger::info("CompanyRepository::bulkLoad rows is ", report.rows, " rows/sec is ", report.rowsPerSec());
+        return report;
+    }
 private:
-    pqxx::work* tx;
+    /**
+     * n 個のキー、ids があればそこから、無ければ generate_series でシーケンスからまとめて採番する。
+    */
+    std::vector<long> nextIds(const std::size_t& n) const
+    {
+        if(ids) {
+            return ids->next(n);
+        }
+        std::vector<long> keys;
+        keys.reserve(n);
+        for(const pqxx::row& r: tx->exec_params("SELECT nextval('table_id_seq') FROM generate_series(1, $1)", static_cast<long>(n))) {
+            keys.push_back(r[0].as<long>());
+        }
+        return keys;
+    }
+    pqxx::work*             tx;
+    IdBlockAllocator<long>* ids;
 };
 
 
@@ -869,22 +1388,22 @@ public:
     {}
     virtual void begin()    const override
     {
-        puts("------ PGSQLTx::begin()");
+        logger::trace("------ PGSQLTx::begin()");
         // none.
     }
     virtual void commit()   const override
     {
-        puts("------ PGSQLTx::commit()");
+        logger::trace("------ PGSQLTx::commit()");
         tx->commit();
     }
     virtual void rollback() const override
     {
-        puts("------ PGSQLTx::rollback()");
+        logger::trace("------ PGSQLTx::rollback()");
         // none. pqxx::work は例外が発生して commit() が呼ばれなければ、勝手に rollback するという認識です（間違ってるかも：）。
     }
     virtual std::optional<DATA> proc() const override
     {
-        puts("------ PGSQLTx::proc()");
+        logger::trace("------ PGSQLTx::proc()");
         return strategy->proc();
     }
 private:
@@ -897,11 +1416,12 @@ private:
 template<class DATA, class PKEY>
 class PGSQLCreateStrategy final : public RdbProcStrategy<DATA> {
 public:
-    PGSQLCreateStrategy(const Repository<DATA, PKEY>* _repo, const DATA& _data): repo(_repo), data(_data)
+    // _data は値で受け取り move する（MySQLCreateStrategy と同じ）
+    PGSQLCreateStrategy(const Repository<DATA, PKEY>* _repo, DATA _data): repo(_repo), data(std::move(_data))
     {}
     virtual std::optional<DATA> proc() const override
     {
-        puts("------ PGSQLCreateStrategy::proc()");
+        logger::trace("------ PGSQLCreateStrategy::proc()");
         try {
             return repo->insert(data);
         } catch(std::exception& e) {
@@ -932,6 +1452,156 @@ int test_CompanyRepository_insert() {
     }
 }
 
+int test_CompanyRepository_IdBlockAllocator() {
+    puts("=== test_CompanyRepository_IdBlockAllocator");
+    try {
+        IdBlockAllocator<long> ids(pgsqlSequenceReserve(appProp.pqx.toString(), "table_id_seq"), 100);
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+        CompanyRepository repo(&tx, &ids);
+        std::set<long> keys;
+        for(int i = 0; i < 250; i++) {
+            std::optional<CompanyData> ret = repo.insert(CompanyData(0l, "Block co. " + std::to_string(i), "東京都"));
+            assert( ret.has_value() == true );
+            keys.insert(ret.value().getId());
+        }
+        std::vector<CompanyData> datas;
+        datas.emplace_back(0l, "Block many 1", "大阪府");
+        datas.emplace_back(0l, "Block many 2", "大阪府");
+        for(const long& k: repo.insertMany(datas)) {
+            keys.insert(k);
+        }
+        tx.commit();
+        ptr_lambda_debug<const char*, const std::size_t&>("refill count is ", ids.refillCount());
+        assert( keys.size() == 252 );
+        assert( ids.refillCount() >= 3 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_CompanyRepository_insertMany() {
+    puts("=== test_CompanyRepository_insertMany");
+    try {
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+
+        std::vector<CompanyData> datas;
+        datas.emplace_back(0l, "ACB 総研", "東京都");
+        datas.emplace_back(0l, "LOKI co.,ltd", "Tokyo, Japan.");
+        datas.emplace_back(0l, "O'Reilly & Co.", "大阪府");      // 引用符を含む値もパラメータとして渡される
+        CompanyRepository repo(&tx);
+        std::vector<long> keys = repo.insertMany(datas, 2);
+        tx.commit();
+        assert(keys.size() == datas.size());
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+int test_CompanyRepository_upsert() {
+    puts("=== test_CompanyRepository_upsert");
+    try {
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+        CompanyRepository repo(&tx);
+        // id が 0 なら採番して登録、同じ id なら更新
+        std::optional<CompanyData> first = repo.upsert(CompanyData(0l, "Upsert Inc.", "東京都"));
+        assert(first.has_value() == true);
+        const long id = first.value().getId();
+        std::optional<CompanyData> second = repo.upsert(CompanyData(id, "Upsert Inc. 2", "大阪府"));
+        assert(second.value().getId() == id);
+        const std::vector<long> ids{id};
+        assert(repo.findByIds(ids).rows[0].value().getAddress() == "大阪府");      // findOne は未実装
+        // 一括版、更新と登録が混在してよい
+        std::vector<CompanyData> datas;
+        datas.emplace_back(id, "Upsert Inc. 3", "新浜市");
+        datas.emplace_back(0l, "Upsert Many", "東京都");
+        repo.upsertMany(datas);
+        assert(repo.findByIds(ids).rows[0].value().getName() == "Upsert Inc. 3");
+        tx.commit();
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+int test_CompanyRepository_bulkLoad() {
+    puts("=== test_CompanyRepository_bulkLoad");
+    try {
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+        std::vector<CompanyData> datas;
+        for(int i = 0; i < 1000; i++) {
+            datas.emplace_back(0l, "Bulk co. " + std::to_string(i), i % 2 ? "Tokyo,\tJapan." : "O'Reilly\n大阪府");     // 区切り、引用符を含む値
+        }
+        CompanyRepository repo(&tx);
+        std::vector<long> keys;
+        BulkLoadReport report = repo.bulkLoad(datas, 300, &keys);
+        tx.commit();
+        ptr_lambda_debug<const char*, const double&>("rows/sec is ", report.rowsPerSec());
+        assert(report.rows == datas.size());
+        assert(report.batches == 4);
+        assert(keys.size() == datas.size());
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_CompanyRepository_findByIds() {
+    puts("=== test_CompanyRepository_findByIds");
+    try {
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+
+        std::vector<CompanyData> datas;
+        datas.emplace_back(0l, "Section 9", "新浜市");
+        datas.emplace_back(0l, "Togusa Inc.", "Tokyo, Japan.");
+        CompanyRepository repo(&tx);
+        std::vector<long> keys = repo.insertMany(datas);
+        std::vector<long> pkeys = {keys[1], -1, keys[0], keys[1]};
+        FindResult<CompanyData, long> result = repo.findByIds(pkeys);
+        tx.commit();
+        assert(result.rows.size() == 4);
+        assert(result.rows[0].has_value() == true && result.rows[0].value().getName() == "Togusa Inc.");
+        assert(result.rows[1].has_value() == false);
+        assert(result.rows[2].has_value() == true && result.rows[2].value().getAddress() == "新浜市");
+        assert(result.missing.size() == 1 && result.missing[0] == -1);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_CompanyRepository_findAll() {
+    puts("=== test_CompanyRepository_findAll");
+    try {
+        pqxx::connection con{appProp.pqx.toString()};
+        pqxx::work tx{con};
+
+        CompanyRepository repo(&tx);
+        std::size_t count = 0;
+        Cursor<CompanyData> cursor = repo.findAll(2);      // サーバ側カーソルから 2 行ずつ
+        while(std::optional<CompanyData> c = cursor.next()) {
+            assert(c.value().getName().empty() == false);
+            count++;
+        }
+        tx.commit();
+        ptr_lambda_debug<const char*, const std::size_t&>("count is ", count);
+        assert(count > 0);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 int test_PGSQLTx_Create() {
     puts("=== test_PGSQLTx_Create");
     try {
@@ -1001,6 +1671,8 @@ int main(void) {
         auto ret = 0;
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_debug_and_error());
         assert(ret == 1);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_logger());
+        assert(ret == 0);
     }
     if(1.00) {
         auto ret = 0;
@@ -1010,6 +1682,10 @@ int main(void) {
         assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_DataField_3());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_DataField_meta());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_DataField_move());
+        assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonData());
         assert(ret == 0);
     }
@@ -1023,6 +1699,22 @@ int main(void) {
         assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_makeFindOneSql());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_makeUpsertSql());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_TableDef());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_bulk_appendRow());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_IdBlockAllocator());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXAsyncRepository());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_IdentityMapRepository());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_IdentityMapRepository_upsert());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CachedRepository());
+        assert(ret == 0);
     }
     if(1.02) {
         auto ret = 0;
@@ -1041,6 +1733,20 @@ int main(void) {
         assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool());
         assert(ret == 1);   // テスト内で明示的に exception を投げている
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_borrow());
+        assert(ret == 1);   // 最後の borrow は timeout を期待している
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_sharded());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_maintenance());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_onEvict());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_discard());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ConnectionPool_stats());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PoolRouter());
+        assert(ret == 0);
     }
     if(1.05) {
         auto ret = 0;
@@ -1052,6 +1758,18 @@ int main(void) {
         assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_insert_no_age());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_insertMany());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_upsert());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_bulkLoad());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_ResultPolicy());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_findByIds());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_findAll());
+        assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PersonRepository_remove());
         assert(ret == 0);
     }
@@ -1062,6 +1780,8 @@ int main(void) {
             assert(ret == 0);
             ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_mysql_connection_pool_B());
             assert(ret == 0);
+            ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLConnection_statement_cache());
+            assert(ret == 0);
         }
         auto ret = 0;
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLTx());
@@ -1078,6 +1798,8 @@ int main(void) {
         assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLTx_Delete(insId.get()));
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_TxExecutor());
+        assert(ret == 0);
     }
     if(2.00) {      // 2.00
         auto ret = 0;
@@ -1091,8 +1813,20 @@ int main(void) {
         assert(ret == 1);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_insert());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_insertMany());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_handles());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_async());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_findByIds());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_ormx_PersonRepository_findAll());
+        assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXCreateStrategy());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_MySQLXGroupCommit());
+        assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_mysqlx_update());
         assert(ret == 1);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_mysqlx_select());
@@ -1116,6 +1850,18 @@ int main(void) {
         assert(ret == 1);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_insert());
         assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_IdBlockAllocator());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_insertMany());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_upsert());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_bulkLoad());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_findByIds());
+        assert(ret == 0);
+        ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_CompanyRepository_findAll());
+        assert(ret == 0);
         ptr_lambda_debug<const char*, const decltype(ret)&>("Play and Result ... ", ret = test_PGSQLTx_Create());
         assert(ret == 0);
     }
@@ -1,40 +1,39 @@
 #include "../../inc/PersonRepository.hpp"
 
-PersonRepository::PersonRepository(const MySQLConnection* _con) : con(_con)
+PersonRepository::PersonRepository(const MySQLConnection* _con, const ResultPolicy& _policy) : con(_con), policy(_policy)
 {}
 std::optional<PersonData> PersonRepository::insert(const PersonData& data) const
 {
-    puts("------ PersonRepository::insert");
-    const std::string sql = makeInsertSql(data.getTableName(), data.getColumns());
-    ptr_lambda_debug<const char*,const decltype(sql)&>("sql: ", sql);
-    std::unique_ptr<sql::PreparedStatement> prep_stmt(con->prepareStatement(sql));
-    auto[id_nam, id_val] = data.getId().bind();
-    auto[name_nam, name_val] = data.getName().bind();
-    prep_stmt->setString(1, name_val);
-    auto[email_nam, email_val] = data.getEmail().bind();
-    prep_stmt->setString(2, email_val);
+    logger::trace("------ PersonRepository::insert");
+    const std::uint32_t mask = data.columnMask();
+    const std::string_view sql = PersonSql::insert[mask].view();     // コンパイル時に生成済み
+    logger::debug("sql: ", sql);
+    sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+    prep_stmt->setString(PersonData::TABLE.bindIndex(PersonData::COL_NAME, mask), data.getName().getValue());
+    prep_stmt->setString(PersonData::TABLE.bindIndex(PersonData::COL_EMAIL, mask), data.getEmail().getValue());
     if(data.getAge().has_value()) {
-        auto[age_nam, age_val] = data.getAge().value().bind();
-        prep_stmt->setInt(3, age_val);
+        prep_stmt->setInt(PersonData::TABLE.bindIndex(PersonData::COL_AGE, mask), data.getAge().value().getValue());
     }
     int ret = prep_stmt->executeUpdate();                       // INSERT 実行
-    ptr_lambda_debug<const char*, const int&>("ret is ", ret);
+    logger::debug("ret is ", ret);
+    if(policy == ResultPolicy::NO_ECHO) {
+        return std::nullopt;                                    // LAST_INSERT_ID の往復を省略する
+    }
 
-    std::unique_ptr<sql::Statement> stmt(con->createStatement());
-    std::string sql_last_insert_id = "SELECT LAST_INSERT_ID()";
-    ptr_lambda_debug<const char*,const decltype(sql_last_insert_id)&>("sql_last_insert_id: ", sql_last_insert_id);
-    std::unique_ptr<sql::ResultSet> res( stmt->executeQuery(sql_last_insert_id) );  // SELECT ... Auto Increment されたライマリキを取得する
+    // JDBC 互換の API には生成されたキー（getGeneratedKeys）が無いため、ECHO でも LAST_INSERT_ID の問い合わせは必要。
+    // createStatement を毎回作らず、キャッシュした Prepared Statement を使う。
+    const std::string sql_last_insert_id = "SELECT LAST_INSERT_ID()";
+    logger::debug("sql_last_insert_id: ", sql_last_insert_id);
+    std::unique_ptr<sql::ResultSet> res( con->prepareCachedStatement(sql_last_insert_id)->executeQuery() );  // SELECT ... Auto Increment されたライマリキを取得する
     while(res->next()) {
-        puts("------ A");
+        logger::trace("------ A");
         auto id = res->getInt64(1);
-        DataField<std::size_t> d_id("id", id);
-        DataField<std::string> d_name("name", data.getName().getValue());
-        DataField<std::string> d_email("email", data.getEmail().getValue());
-        std::optional<DataField<int>> d_age = std::nullopt;
-        if(data.getAge().has_value()) {
-            d_age = DataField<int>("age", data.getAge().value().getValue());
-        }
-        return PersonData(data.getDataStrategy(), d_id, d_name, d_email, d_age);
+        if(policy == ResultPolicy::REFETCH) {
+            return findOne(id);
+        }
+        // 戻り値の optional の中に直接作る（文字列のコピーはカラムごとに 1 回）
+        return std::optional<PersonData>(std::in_place, data.getDataStrategy()
+            , DataField<std::size_t>(PersonData::schema().id, id), data.getName(), data.getEmail(), data.getAge());
         // ptr_lambda_debug<const char*, const decltype(id)&>("id is ", id);
         // ptr_lambda_debug<const char*, const std::string&>("id type is ", typeid(id).name());
         // auto sql_2 = makeFindOneSql(data.getTableName(), id_nam, data.getColumns());
@@ -69,41 +68,47 @@ std::optional<PersonData> PersonRepository::insert(const PersonData& data) const
 
 std::optional<PersonData> PersonRepository::update(const PersonData& data) const
 {
-    puts("------ PersonRepository::update");
-    ptr_lambda_debug<const char*,const RdbDataStrategy<PersonData>*>("stragety addr is ", data.getDataStrategy());
-    auto[debug_id_nam, debug_id_val] = data.getId().bind();
-    ptr_lambda_debug<const char*,const decltype(debug_id_nam)&>("debug_id_nam is ", debug_id_nam);
-    ptr_lambda_debug<const char*,const decltype(debug_id_val)&>("debug_id_val is ", debug_id_val);
-
-    const std::string sql = makeUpdateSql(data.getTableName(), data.getId().getName(), data.getColumns());
-    ptr_lambda_debug<const char*,const std::string&>("sql: ", sql);
-    std::unique_ptr<sql::PreparedStatement> prep_stmt(con->prepareStatement(sql));
-    auto[name_nam, name_val] = data.getName().bind();
-    prep_stmt->setString(1, name_val);
-    auto[email_nam, email_val] = data.getEmail().bind();
-    prep_stmt->setString(2, email_val);
+    logger::trace("------ PersonRepository::update");
+    logger::debug("stragety addr is ", data.getDataStrategy());
+    if constexpr (logger::enabled<logger::Level::debug>) {     // bind() の複製は debug の場合のみ
+        auto[debug_id_nam, debug_id_val] = data.getId().bind();
+        logger::debug("debug_id_nam is ", debug_id_nam);
+        logger::debug("debug_id_val is ", debug_id_val);
+    }
+
+    const std::uint32_t mask = data.columnMask();
+    const std::string_view sql = PersonSql::update[mask].view();     // コンパイル時に生成済み
+    logger::debug("sql: ", sql);
+    sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+    prep_stmt->setString(PersonData::TABLE.bindIndex(PersonData::COL_NAME, mask), data.getName().getValue());
+    prep_stmt->setString(PersonData::TABLE.bindIndex(PersonData::COL_EMAIL, mask), data.getEmail().getValue());
     if(data.getAge().has_value()) {
-        auto[age_nam, age_val] = data.getAge().value().bind();
-        prep_stmt->setInt(3, age_val);
+        prep_stmt->setInt(PersonData::TABLE.bindIndex(PersonData::COL_AGE, mask), data.getAge().value().getValue());
     }
-    auto[id_nam, id_val] = data.getId().bind();
-    prep_stmt->setBigInt(4, std::to_string(id_val));
+    // age が無い場合は WHERE の位置が 1 つ前になる
+    prep_stmt->setBigInt(PersonData::TABLE.pkeyBindIndex(mask), std::to_string(data.getId().getValue()));
     int ret = prep_stmt->executeUpdate();                       // Update 実行
-    ptr_lambda_debug<const char*, const int&>("ret is ", ret);
-    // return data;        // findOne したものを返却すべきなのか、悩ましい。
-    return findOne(data.getId().getValue());
+    logger::debug("ret is ", ret);
+    // return data;        // findOne したものを返却すべきなのか、悩ましい。 -> ResultPolicy で選択できるようにした。
+    switch(policy) {
+    case ResultPolicy::NO_ECHO:
+        return std::nullopt;
+    case ResultPolicy::ECHO:
+        return data;
+    default:
+        return findOne(data.getId().getValue());
+    }
 }
 
 void PersonRepository::remove(const std::size_t& pkey) const
 {   
-    puts("------ PersonRepository::remove");
-    PersonData data = PersonData::dummy();
-    std::string sql = makeDeleteSql(data.getTableName(), data.getId().getName());
-    ptr_lambda_debug<const char*, const std::string&>("sql: ", sql);
-    std::unique_ptr<sql::PreparedStatement> prep_stmt(con->prepareStatement(sql));
+    logger::trace("------ PersonRepository::remove");
+    const std::string_view sql = PersonSql::remove.view();
+    logger::debug("sql: ", sql);
+    sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
     prep_stmt->setBigInt(1, std::to_string(pkey));
     int ret = prep_stmt->executeUpdate();                       // Delete 実行
-    ptr_lambda_debug<const char*, const int&>("ret is ", ret);
+    logger::debug("ret is ", ret);
 
 }
 
@@ -114,53 +119,269 @@ std::optional<PersonData> PersonRepository::findOne(const std::size_t& pkey) con
      * よって、内部の実装で PersonData を利用すればいいし、何らかの手段で動的に SQL が構築できれば
      * 問題ないと考える。
     */
-    puts("------ PersonRepository::findOne");
-    DataField<std::size_t> id("id", pkey);
-    DataField<std::string> name("name", "");
-    DataField<std::string> email("email", "");
-    DataField<int>         age("age", 0);
-    std::unique_ptr<RdbDataStrategy<PersonData>> dataStratedy = std::make_unique<PersonStrategy>(PersonStrategy());
-    // 上記一連を作る factory が欲しくなる、どこに作るべきかな、最終的に PersonData を返却してくれたらいいので、PersonData の static メンバ関数ではどうだろうか。
-    PersonData data(dataStratedy.get(), id, name, email, age);
-    std::string sql = makeFindOneSql(data.getTableName(), id.getName(), data.getColumns());     // makeFindOneSql に namespace は必要かな？
-    ptr_lambda_debug<const char*, const std::string&>("sql: ", sql);
-    std::unique_ptr<sql::PreparedStatement> prep_stmt(con->prepareStatement(sql));
+    logger::trace("------ PersonRepository::findOne");
+    // 以前は検索のためだけに PersonData を作り makeFindOneSql で SQL を組み立てていたが、PersonSql の定数を使う。
+    const std::string_view sql = PersonSql::findOne.view();
+    logger::debug("sql: ", sql);
+    sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
     prep_stmt->setBigInt(1, std::to_string(pkey));
     std::unique_ptr<sql::ResultSet> res(prep_stmt->executeQuery());
     while(res->next()) {
-        puts("------ A");
+        logger::trace("------ A");
+        if(res->isNull(PersonData::COL_AGE + 1)) {
+            return PersonData::factoryNoAge(res.get(), nullptr);
+        }
         return PersonData::factory(res.get(), nullptr);
     }
     return std::nullopt;
 }
 
+/**
+ * 複数行の一括登録。
+ *
+ * age の有無が行ごとに異なっても同じ SQL を使えるように、カラムは常に name, email, age とし、
+ * age が無い行は NULL をバインドする。チャンクごとに SQL 文は 1 つ（端数のチャンクを含めて 2 種類）なので、
+ * Prepared Statement はキャッシュから再利用される。
+ *
+ * 採番されたキーは、チャンクごとの LAST_INSERT_ID()（チャンクの先頭行の値）から連番で求める。
+ * 行数が確定している INSERT（simple insert）は AUTO_INCREMENT の値がまとめて連続して割り当てられるため。
+ * auto_increment_increment が 1 以外のサーバでは成り立たないことに注意。
+*/
+
+std::vector<std::size_t> PersonRepository::insertMany(std::span<const PersonData> datas, const std::size_t& chunkSize) const
+{
+    logger::trace("------ PersonRepository::insertMany");
+    std::vector<std::size_t> keys;
+    if(datas.empty()) {
+        return keys;
+    }
+    keys.reserve(datas.size());
+    const std::vector<std::string> cols = PersonData::TABLE.columnNames(1u);      // age を含むすべてのカラム
+    const std::size_t maxRows = 65535 / cols.size();        // プレースホルダの上限
+    const std::size_t rows    = std::max<std::size_t>(1, std::min(chunkSize, maxRows));
+    std::unique_ptr<sql::Statement> stmt(con->createStatement());
+    for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+        std::span<const PersonData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+        const std::string sql = makeInsertSql(PersonData::schema().tableName, cols, chunk.size());
+        sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+        unsigned int index = 1;
+        for(const PersonData& data: chunk) {
+            prep_stmt->setString(index++, data.getName().getValue());
+            prep_stmt->setString(index++, data.getEmail().getValue());
+            if(data.getAge().has_value()) {
+                prep_stmt->setInt(index++, data.getAge().value().getValue());
+            } else {
+                prep_stmt->setNull(index++, sql::DataType::INTEGER);
+            }
+        }
+        int ret = prep_stmt->executeUpdate();                   // INSERT 実行（チャンク単位）
+        logger::debug("ret is ", ret);
+        std::unique_ptr<sql::ResultSet> res( stmt->executeQuery("SELECT LAST_INSERT_ID()") );
+        if(!res->next()) {
+            throw std::runtime_error("LAST_INSERT_ID() returned no rows.");
+        }
+        const std::size_t first = res->getUInt64(1);
+        for(std::size_t i = 0; i < chunk.size(); i++) {
+            keys.push_back(first + i);
+        }
+    }
+    return keys;
+}
+
+/**
+ * upsert、upsertMany の 1 行分のバインド（id, name, email, age の順）、次の index を返す。
+ * id が 0 の行は NULL をバインドして新規に採番させる。age が無い行は NULL とする。
+*/
+
+static unsigned int bindUpsertRow(sql::PreparedStatement* prep_stmt, unsigned int index, const PersonData& data)
+{
+    if(data.getId().getValue() == 0) {
+        prep_stmt->setNull(index++, sql::DataType::BIGINT);
+    } else {
+        prep_stmt->setBigInt(index++, std::to_string(data.getId().getValue()));
+    }
+    prep_stmt->setString(index++, data.getName().getValue());
+    prep_stmt->setString(index++, data.getEmail().getValue());
+    if(data.getAge().has_value()) {
+        prep_stmt->setInt(index++, data.getAge().value().getValue());
+    } else {
+        prep_stmt->setNull(index++, sql::DataType::INTEGER);
+    }
+    return index;
+}
+
+/**
+ * 1 行の upsert、INSERT ... ON DUPLICATE KEY UPDATE を 1 回発行する。
+ *
+ * id（プライマリキ）、email（UNIQUE）のいずれかが重複した場合はその行を更新する。
+ * 行全体を置き換える、age が無い場合は NULL にする（update と異なり、upsertMany と同じ SQL にするため）。
+ * キーは LAST_INSERT_ID() で得る（更新の場合も id = LAST_INSERT_ID(id) でその行のキーになる）。
+ * ただし id を明示して登録した場合、LAST_INSERT_ID() は更新されない（0 か、以前の登録のキーのまま）ので data の id を使う。
+*/
+
+std::optional<PersonData> PersonRepository::upsert(const PersonData& data) const
+{
+    logger::trace("------ PersonRepository::upsert");
+    static const std::string sql = makeUpsertSql(PersonData::schema().tableName
+        , std::string(PersonData::TABLE.columns[PersonData::COL_ID].name), PersonData::TABLE.columnNames(1u));
+    logger::debug("sql: ", sql);
+    sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+    bindUpsertRow(prep_stmt, 1, data);
+    int ret = prep_stmt->executeUpdate();                       // 登録は 1、更新は 2、変更なしは 0
+    logger::debug("ret is ", ret);
+    if(policy == ResultPolicy::NO_ECHO) {
+        return std::nullopt;
+    }
+    std::size_t id = data.getId().getValue();
+    if(ret != 1 || id == 0) {               // NULL で採番した登録、あるいは ON DUPLICATE KEY の更新
+        std::unique_ptr<sql::ResultSet> res( con->prepareCachedStatement("SELECT LAST_INSERT_ID()")->executeQuery() );
+        if(!res->next()) {
+            throw std::runtime_error("LAST_INSERT_ID() returned no rows.");
+        }
+        id = res->getUInt64(1);
+    }
+    if(policy == ResultPolicy::REFETCH) {
+        return findOne(id);
+    }
+    return std::optional<PersonData>(std::in_place, data.getDataStrategy()
+        , DataField<std::size_t>(PersonData::schema().id, id), data.getName(), data.getEmail(), data.getAge());
+}
+
+/**
+ * 複数行の upsert、チャンクごとに 1 つの INSERT ... ON DUPLICATE KEY UPDATE を発行する。
+ * SQL 文はチャンクの行数ごとに 1 つなので、Prepared Statement はキャッシュから再利用される（insertMany と同じ）。
+*/
+
+void PersonRepository::upsertMany(std::span<const PersonData> datas, const std::size_t& chunkSize) const
+{
+    logger::trace("------ PersonRepository::upsertMany");
+    const std::vector<std::string> cols = PersonData::TABLE.columnNames(1u);      // age を含むすべてのカラム
+    const std::string pkeyName(PersonData::TABLE.columns[PersonData::COL_ID].name);
+    const std::size_t maxRows = 65535 / (cols.size() + 1);  // プレースホルダの上限
+    const std::size_t rows    = std::max<std::size_t>(1, std::min(chunkSize, maxRows));
+    for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+        std::span<const PersonData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+        const std::string sql = makeUpsertSql(PersonData::schema().tableName, pkeyName, cols, chunk.size());
+        sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+        unsigned int index = 1;
+        for(const PersonData& data: chunk) {
+            index = bindUpsertRow(prep_stmt, index, data);
+        }
+        int ret = prep_stmt->executeUpdate();                   // upsert 実行（チャンク単位）
+        logger::debug("ret is ", ret);
+    }
+}
+
+/**
+ * 複数キーの一括取得、チャンクごとに IN (?, ?, ...) の SELECT を 1 回発行する。
+ * age が NULL の行は age なしの PersonData とする。
+*/
+
+FindResult<PersonData, std::size_t> PersonRepository::findByIds(std::span<const std::size_t> pkeys, const std::size_t& chunkSize) const
+{
+    logger::trace("------ PersonRepository::findByIds");
+    const std::vector<std::string> cols = PersonData::TABLE.columnNames(1u);      // age を含むすべてのカラム
+    const std::string pkeyName(PersonData::TABLE.columns[PersonData::COL_ID].name);
+    return findByIdsChunked(pkeys, std::min<std::size_t>(chunkSize, 65535), [&](std::span<const std::size_t> chunk) {
+        const std::string sql = makeFindByIdsSql(PersonData::schema().tableName, pkeyName, cols, chunk.size());
+        logger::debug("sql: ", sql);
+        sql::PreparedStatement* prep_stmt = con->prepareCachedStatement(sql);     // 所有権は MySQLConnection のキャッシュにある
+        for(std::size_t i = 0; i < chunk.size(); i++) {
+            prep_stmt->setBigInt(static_cast<unsigned int>(i + 1), std::to_string(chunk[i]));
+        }
+        std::vector<std::pair<std::size_t, PersonData>> rows;
+        rows.reserve(chunk.size());
+        std::unique_ptr<sql::ResultSet> res(prep_stmt->executeQuery());
+        while(res->next()) {
+            const std::size_t id = res->getUInt64(1);
+            if(res->isNull(PersonData::COL_AGE + 1)) {
+                rows.emplace_back(id, PersonData::factoryNoAge(res.get(), nullptr));
+            } else {
+                rows.emplace_back(id, PersonData::factory(res.get(), nullptr));
+            }
+        }
+        return rows;
+    });
+}
+
+/**
+ * 全件の走査。
+ *
+ * TYPE_FORWARD_ONLY を指定して、結果をクライアントにまとめてバッファせず、サーバから順に受け取る。
+ * このドライバは sql::Statement::setFetchSize を実装していない（MethodNotImplementedException）ので、fetchSize は無視する。
+ * Statement と ResultSet は Cursor（のラムダ）が所有し、Cursor の破棄で閉じられる。
+ * ResultSet を読み切るまで、このコネクションでは別の問い合わせができないことに注意（MySQL プロトコルの制約）。
+*/
+
+Cursor<PersonData> PersonRepository::findAll(const std::size_t&) const
+{
+    logger::trace("------ PersonRepository::findAll");
+    const std::string sql(PersonSql::findAll.view());
+    logger::debug("sql: ", sql);
+    std::shared_ptr<sql::Statement> stmt(con->createStatement());
+    stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+    std::shared_ptr<sql::ResultSet> res(stmt->executeQuery(sql));
+    return Cursor<PersonData>([stmt, res]() -> std::optional<PersonData> {
+        if(!res->next()) {
+            return std::nullopt;
+        }
+        if(res->isNull(PersonData::COL_AGE + 1)) {
+            return PersonData::factoryNoAge(res.get(), nullptr);
+        }
+        return PersonData::factory(res.get(), nullptr);
+    });
+}
+
+BulkLoadReport PersonRepository::bulkLoad(std::span<const PersonData> datas, const std::size_t& chunkRows) const
+{
+    logger::trace("------ PersonRepository::bulkLoad");
+    static const auto desc = makeBulkDescriptor<PersonData>(PersonData::schema().tableName
+        , {PersonData::TABLE.columns[PersonData::COL_NAME].name, PersonData::TABLE.columns[PersonData::COL_EMAIL].name, PersonData::TABLE.columns[PersonData::COL_AGE].name}
+        , [](const PersonData& d) -> const std::string& { return d.getName().getValue(); }
+        , [](const PersonData& d) -> const std::string& { return d.getEmail().getValue(); }
+        , [](const PersonData& d) -> std::optional<int> {
+            return d.getAge().has_value() ? std::optional<int>(d.getAge().value().getValue()) : std::nullopt;
+        });
+    BulkLoadReport report = mysqlLoadData(con, desc, datas, chunkRows);
+    logger::info("PersonRepository::bulkLoad rows is ", report.rows, " rows/sec is ", report.rowsPerSec());
+    return report;
+}
+
 /**
  * 以下
  * namespace ormx
 */
 
-ormx::PersonRepository::PersonRepository(mysqlx::Session* _session): session(_session)
+ormx::PersonRepository::PersonRepository(mysqlx::Session* _session, ormx::MySQLXHandleCache* _handles): session(_session), handles(_handles)
 {}
+mysqlx::Table& ormx::PersonRepository::table() const
+{
+    if(handles) {
+        return handles->table(session, "cheshire", "person");
+    }
+    if(!person.has_value()) {
+        person.emplace(session->getSchema("cheshire").getTable("person"));
+    }
+    return person.value();
+}
 std::optional<ormx::PersonData> ormx::PersonRepository::insert(const ormx::PersonData& data) const
 {
-    puts("------ ormx::PersonRepository::insert()");
+    logger::trace("------ ormx::PersonRepository::insert()");
     // 実装
-    mysqlx::Schema cheshire = session->getSchema("cheshire");
-    mysqlx::Table person = cheshire.getTable("person");
-        
+    mysqlx::Table& person = table();
     mysqlx::Result res;
     if( data.getAge().has_value() ) {
         res = person.insert("name", "email", "age")
                     .values(data.getName(), data.getEmail(), data.getAge().value())
                     .execute();
-        std::cout <<  res.getAutoIncrementValue() << std::endl;     // 最初に Insert したレコードの pkey (AUTO INCREMENT) の値
-        return ormx::PersonData(res.getAutoIncrementValue(), data.getName(), data.getEmail(), data.getAge().value());
+        logger::debug("insert id is ", res.getAutoIncrementValue());     // 最初に Insert したレコードの pkey (AUTO INCREMENT) の値
+        return std::optional<ormx::PersonData>(std::in_place, res.getAutoIncrementValue(), data.getName(), data.getEmail(), data.getAge().value());
     } else {
         res = person.insert("name", "email")
                     .values(data.getName(), data.getEmail())
                     .execute();
-        std::cout <<  res.getAutoIncrementValue() << std::endl;     // 最初に Insert したレコードの pkey (AUTO INCREMENT) の値
-        return ormx::PersonData(res.getAutoIncrementValue(), data.getName(), data.getEmail());
+        logger::debug("insert id is ", res.getAutoIncrementValue());     // 最初に Insert したレコードの pkey (AUTO INCREMENT) の値
+        return std::optional<ormx::PersonData>(std::in_place, res.getAutoIncrementValue(), data.getName(), data.getEmail());
     }
 }
 std::optional<ormx::PersonData> ormx::PersonRepository::update(const ormx::PersonData& data) const {
@@ -175,3 +396,141 @@ std::optional<ormx::PersonData> ormx::PersonRepository::findOne(const std::size_
     return std::nullopt;        
 }
 
+
+/**
+ * 複数行の一括登録、TableInsert に values() を行数分つなげて 1 回の execute() で登録する。
+ * 採番されたキーは getAutoIncrementValue()（チャンクの先頭行の値）から連番で求める、考え方は PersonRepository::insertMany と同じ。
+*/
+std::vector<std::size_t> ormx::PersonRepository::insertMany(std::span<const ormx::PersonData> datas, const std::size_t& chunkSize) const
+{
+    logger::trace("------ ormx::PersonRepository::insertMany()");
+    std::vector<std::size_t> keys;
+    keys.reserve(datas.size());
+    mysqlx::Table& person = table();
+    const std::size_t rows = std::max<std::size_t>(1, chunkSize);
+    for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+        std::span<const ormx::PersonData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+        mysqlx::TableInsert tblIns = person.insert("name", "email", "age");
+        for(const ormx::PersonData& data: chunk) {
+            if(data.getAge().has_value()) {
+                tblIns.values(data.getName(), data.getEmail(), data.getAge().value());
+            } else {
+                tblIns.values(data.getName(), data.getEmail(), mysqlx::Value());      // 引数なしの Value は NULL
+            }
+        }
+        mysqlx::Result res = tblIns.execute();
+        const std::size_t first = res.getAutoIncrementValue();
+        for(std::size_t i = 0; i < chunk.size(); i++) {
+            keys.push_back(first + i);
+        }
+    }
+    return keys;
+}
+
+/**
+ * ormx の upsert、upsertMany の SQL。ormx::PersonData も同じ person テーブルなので、テーブルとカラムは PersonData::TABLE の宣言を使う。
+ * session->sql() は既定のスキーマを持たないので、スキーマ名を付ける。バインドは id, name, email, age の順（TABLE の宣言順）。
+*/
+
+static const std::vector<std::string>& ormxUpsertColumns()
+{
+    static const std::vector<std::string> cols = PersonData::TABLE.columnNames(1u);       // age を含むすべてのカラム
+    return cols;
+}
+static std::string ormxUpsertSql(const std::size_t& rows)
+{
+    return makeUpsertSql("cheshire." + PersonData::schema().tableName
+        , std::string(PersonData::TABLE.columns[PersonData::COL_ID].name), ormxUpsertColumns(), rows);
+}
+
+/**
+ * upsert、X DevAPI の CRUD には ON DUPLICATE KEY UPDATE が無いので、sql_generator の SQL を session->sql() で実行する。
+ * 考え方は PersonRepository::upsert と同じ（id が 0 の場合は NULL で採番、age が無い場合は NULL）。
+ * キーは getAutoIncrementValue()（id = LAST_INSERT_ID(id) により更新の場合もその行のキー）で得る。
+*/
+std::optional<ormx::PersonData> ormx::PersonRepository::upsert(const ormx::PersonData& data) const
+{
+    logger::trace("------ ormx::PersonRepository::upsert()");
+    static const std::string sql = ormxUpsertSql(1);
+    logger::debug("sql: ", sql);
+    mysqlx::SqlStatement stmt = session->sql(sql);
+    stmt.bind(data.getId() ? mysqlx::Value(data.getId()) : mysqlx::Value()).bind(data.getName()).bind(data.getEmail())
+        .bind(data.getAge().has_value() ? mysqlx::Value(data.getAge().value()) : mysqlx::Value());      // 引数なしの Value は NULL
+    mysqlx::SqlResult res = stmt.execute();
+    const std::size_t id = res.getAutoIncrementValue() ? res.getAutoIncrementValue() : data.getId();
+    if(data.getAge().has_value()) {
+        return std::optional<ormx::PersonData>(std::in_place, id, data.getName(), data.getEmail(), data.getAge().value());
+    }
+    return std::optional<ormx::PersonData>(std::in_place, id, data.getName(), data.getEmail());
+}
+/**
+ * 複数行の upsert、チャンクごとに 1 つの文を session->sql() で実行する。
+*/
+void ormx::PersonRepository::upsertMany(std::span<const ormx::PersonData> datas, const std::size_t& chunkSize) const
+{
+    logger::trace("------ ormx::PersonRepository::upsertMany()");
+    const std::size_t maxRows = 65535 / (ormxUpsertColumns().size() + 1);  // プレースホルダの上限
+    const std::size_t rows    = std::max<std::size_t>(1, std::min(chunkSize, maxRows));
+    for(std::size_t offset = 0; offset < datas.size(); offset += rows) {
+        std::span<const ormx::PersonData> chunk = datas.subspan(offset, std::min(rows, datas.size() - offset));
+        mysqlx::SqlStatement stmt = session->sql(ormxUpsertSql(chunk.size()));
+        for(const ormx::PersonData& data: chunk) {
+            stmt.bind(data.getId() ? mysqlx::Value(data.getId()) : mysqlx::Value()).bind(data.getName()).bind(data.getEmail())
+                .bind(data.getAge().has_value() ? mysqlx::Value(data.getAge().value()) : mysqlx::Value());
+        }
+        stmt.execute();
+    }
+}
+
+/**
+ * 複数キーの一括取得、where 句に名前付きのプレースホルダ（:k0, :k1, ...）を並べて bind する。
+*/
+FindResult<ormx::PersonData, std::size_t> ormx::PersonRepository::findByIds(std::span<const std::size_t> pkeys, const std::size_t& chunkSize) const
+{
+    logger::trace("------ ormx::PersonRepository::findByIds()");
+    mysqlx::Table& person = table();
+    return findByIdsChunked(pkeys, chunkSize, [&](std::span<const std::size_t> chunk) {
+        std::string where("id IN (");
+        for(std::size_t i = 0; i < chunk.size(); i++) {
+            where.append(i ? ", :k" : ":k").append(std::to_string(i));
+        }
+        where.append(")");
+        mysqlx::TableSelect tblSel = person.select("id", "name", "email", "age").where(where);
+        for(std::size_t i = 0; i < chunk.size(); i++) {
+            tblSel.bind("k" + std::to_string(i), chunk[i]);
+        }
+        std::vector<std::pair<std::size_t, ormx::PersonData>> rows;
+        rows.reserve(chunk.size());
+        mysqlx::RowResult res = tblSel.execute();
+        for(mysqlx::Row row: res) {
+            const std::size_t id = row[0].get<std::size_t>();
+            if(row[3].isNull()) {
+                rows.emplace_back(id, ormx::PersonData(id, row[1].get<std::string>(), row[2].get<std::string>()));
+            } else {
+                rows.emplace_back(id, ormx::PersonData(id, row[1].get<std::string>(), row[2].get<std::string>(), row[3].get<int>()));
+            }
+        }
+        return rows;
+    });
+}
+
+/**
+ * 全件の走査、RowResult::fetchOne で 1 行ずつ取り出す。
+ * X Protocol は行を順に送ってくるため、fetchSize に相当する指定は無い（無視する）。
+*/
+Cursor<ormx::PersonData> ormx::PersonRepository::findAll(const std::size_t&) const
+{
+    logger::trace("------ ormx::PersonRepository::findAll()");
+    mysqlx::Table& person = table();
+    std::shared_ptr<mysqlx::RowResult> res = std::make_shared<mysqlx::RowResult>(person.select("id", "name", "email", "age").execute());
+    return Cursor<ormx::PersonData>([res]() -> std::optional<ormx::PersonData> {
+        mysqlx::Row row = res->fetchOne();
+        if(!row) {
+            return std::nullopt;
+        }
+        if(row[3].isNull()) {
+            return ormx::PersonData(row[0].get<std::size_t>(), row[1].get<std::string>(), row[2].get<std::string>());
+        }
+        return ormx::PersonData(row[0].get<std::size_t>(), row[1].get<std::string>(), row[2].get<std::string>(), row[3].get<int>());
+    });
+}
@@ -46,6 +46,44 @@ std::string makeInsertSql(const std::string& tableName, const std::vector<std::s
 }
 
 
+/**
+ * 複数行の INSERT 文、VALUES 句を rows 回繰り返す。
+ *
+ * INSERT INTO test (id, label) VALUES (?, ?), (?, ?), (?, ?)
+ *
+ * プレースホルダの数（colNames.size() * rows）は MySQL の上限 65535 を超えないこと。
+*/
+
+std::string makeInsertSql(const std::string& tableName, const std::vector<std::string>& colNames, const std::size_t& rows) {
+    std::string sql("INSERT INTO ");
+    sql.append(tableName);
+    // カラム
+    std::string cols(" (");
+    // 値（1 行分）
+    std::string tuple("(");
+    for(std::size_t i=0 ; i<colNames.size(); i++) {
+        cols.append(colNames.at(i));
+        tuple.append("?");
+        if( i < colNames.size()-1 ) {
+            cols.append(", ");
+            tuple.append(", ");
+        }
+    }
+    cols.append(") ");
+    tuple.append(")");
+    sql.reserve(sql.size() + cols.size() + 7 + rows * (tuple.size() + 2));
+    sql.append(std::move(cols));
+    sql.append("VALUES ");
+    for(std::size_t r = 0; r < rows; r++) {
+        sql.append(tuple);
+        if( r < rows-1 ) {
+            sql.append(", ");
+        }
+    }
+    return sql;
+}
+
+
 /**
  * UPDATE (表名) SET (カラム名1) = (値1) WHERE id = ?
  * 
@@ -116,6 +154,94 @@ std::string makeFindOneSql(const std::string& tableName, const std::string& pkey
 }
 
 
+/**
+ * SELECT primary-key, col1, col2 FROM table WHERE primary-key IN (?, ?, ?)
+ *
+ * makeFindOneSql の複数キー版、? は keys 個。colNames に pkey は存在しないものとする。
+ * プレースホルダの数は MySQL の上限 65535 を超えないこと。
+*/
+
+std::string makeFindByIdsSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& keys) {
+    std::string sql("SELECT ");
+    sql.append(pkeyName);
+    for(std::size_t i = 0; i < colNames.size(); i++) {
+        sql.append(", ").append(colNames.at(i));
+    }
+    sql.append(" FROM ").append(tableName).append(" WHERE ").append(pkeyName).append(" IN (");
+    sql.reserve(sql.size() + keys * 3 + 1);
+    for(std::size_t i = 0; i < keys; i++) {
+        sql.append(i ? ", ?" : "?");
+    }
+    sql.append(")");
+    return sql;
+}
+
+
+/**
+ * INSERT ... ON DUPLICATE KEY UPDATE（MySQL）、findOne してから insert / update を選ぶ 2 往復の代わり。
+ *
+ * INSERT INTO person (id, name, email) VALUES (?, ?, ?), (?, ?, ?) AS new
+ *   ON DUPLICATE KEY UPDATE id = LAST_INSERT_ID(id), name = new.name, email = new.email
+ *
+ * 挿入しようとした値は行の別名（AS new）で参照する、VALUES(col) は MySQL 8.0.20 から非推奨（別名は 8.0.19 以降）。
+ * pkey（AUTO_INCREMENT）に NULL をバインドした行は新規に採番される。プライマリキ、UNIQUE のいずれかが重複した行は更新する。
+ * id = LAST_INSERT_ID(id) により、1 行の場合は更新でも LAST_INSERT_ID() でその行のキーが得られる。
+ * colNames に pkey は存在しないものとする。プレースホルダの数は MySQL の上限 65535 を超えないこと。
+*/
+
+std::string makeUpsertSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& rows) {
+    std::vector<std::string> cols;
+    cols.reserve(colNames.size() + 1);
+    cols.push_back(pkeyName);
+    cols.insert(cols.end(), colNames.begin(), colNames.end());
+    std::string sql = makeInsertSql(tableName, cols, rows);
+    sql.append(" AS new ON DUPLICATE KEY UPDATE ").append(pkeyName).append(" = LAST_INSERT_ID(").append(pkeyName).append(")");
+    for(std::size_t i = 0; i < colNames.size(); i++) {
+        sql.append(", ").append(colNames.at(i)).append(" = new.").append(colNames.at(i));
+    }
+    return sql;
+}
+
+
+/**
+ * INSERT ... ON CONFLICT DO UPDATE（PostgreSQL）、プレースホルダは $1, $2, ... とする。
+ *
+ * INSERT INTO company (id, name, address) VALUES ($1, $2, $3), ($4, $5, $6)
+ *   ON CONFLICT (id) DO UPDATE SET name = EXCLUDED.name, address = EXCLUDED.address
+ *
+ * 衝突の判定はプライマリキのみ、キーは呼び出し側が採番してバインドすること。
+ * 1 つの文に同じキーの行を複数含めることはできない（PostgreSQL の制約、同じ行を 2 回更新できない）。
+ * colNames に pkey は存在しないものとする。
+*/
+
+std::string makePgUpsertSql(const std::string& tableName, const std::string& pkeyName, const std::vector<std::string>& colNames, const std::size_t& rows) {
+    const std::size_t width = colNames.size() + 1;
+    std::string sql("INSERT INTO ");
+    sql.append(tableName).append(" (").append(pkeyName);
+    for(std::size_t i = 0; i < colNames.size(); i++) {
+        sql.append(", ").append(colNames.at(i));
+    }
+    sql.append(") VALUES ");
+    for(std::size_t r = 0; r < rows; r++) {
+        sql.append(r ? ", (" : "(");
+        for(std::size_t i = 0; i < width; i++) {
+            sql.append(i ? ", $" : "$").append(std::to_string(r * width + i + 1));
+        }
+        sql.append(")");
+    }
+    sql.append(" ON CONFLICT (").append(pkeyName).append(")");
+    if(colNames.empty()) {
+        sql.append(" DO NOTHING");
+        return sql;
+    }
+    sql.append(" DO UPDATE SET ");
+    for(std::size_t i = 0; i < colNames.size(); i++) {
+        sql.append(i ? ", " : "").append(colNames.at(i)).append(" = EXCLUDED.").append(colNames.at(i));
+    }
+    return sql;
+}
+
+
 /**
  * TODO 各 テーブル情報を管理するクラスに CREATE TABLE 文を自動作成する機能がほしい。
  * 
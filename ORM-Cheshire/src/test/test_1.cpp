@@ -47,6 +47,278 @@ int test_ConnectionPool() {
     }
 }
 
+/**
+ * borrow（Lease）の確認。
+ *
+ * - スコープを抜けると自動で Pool に返却されること。
+ * - 例外の経路でも返却されること。
+ * - 空の Pool では timeout まで待ち、別スレッドからの返却を受け取れること。
+*/
+
+int test_ConnectionPool_borrow() {
+    puts("=== test_ConnectionPool_borrow");
+    try {
+        ConnectionPool<Widget> cp;
+        cp.push(new Widget(21));
+        {
+            ConnectionPool<Widget>::Lease lease = cp.borrow();
+            ptr_lambda_debug<const char*, const int&>("value is ", lease->getValue());
+            assert(cp.empty() == true);
+        }
+        assert(cp.empty() == false);        // スコープを抜けたので返却されている
+        try {
+            ConnectionPool<Widget>::Lease lease = cp.borrow();
+            throw std::runtime_error("It's lease test error.");
+        } catch(std::exception& e) {
+            ptr_print_error<const decltype(e)&>(e);
+        }
+        assert(cp.empty() == false);        // 例外の経路でも返却されている
+
+        ConnectionPool<Widget>::Lease first = cp.borrow();
+        std::thread th([&first]{
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            first.release();
+        });
+        ConnectionPool<Widget>::Lease second = cp.borrow(std::chrono::milliseconds(1000));
+        th.join();
+        assert(second.get() != nullptr);
+        ptr_lambda_debug<const char*, const int&>("value is ", second->getValue());
+
+        ConnectionPool<Widget>::Lease third = cp.borrow(std::chrono::milliseconds(5));     // これは timeout
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+
+/**
+ * シャードモードの確認。
+ * 複数スレッドで borrow と返却を繰り返しても、Pool されているオブジェクトの数が変わらないこと。
+ * 各スレッドのホームシャードは異なるので、空のシャードからは隣のシャードを奪うことになる。
+*/
+
+int test_ConnectionPool_sharded() {
+    puts("=== test_ConnectionPool_sharded");
+    try {
+        const int sum = 8;
+        ConnectionPool<Widget> cp("Widget.", 4);
+        ptr_lambda_debug<const char*, const std::size_t&>("shard count is ", cp.shardCount());
+        for(int i = 0; i < sum; i++) {
+            cp.push(new Widget(i));
+        }
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 16; t++) {
+            threads.emplace_back([&cp]{
+                for(int i = 0; i < 1000; i++) {
+                    ConnectionPool<Widget>::Lease lease = cp.borrow(std::chrono::milliseconds(1000));
+                    assert(lease->getValue() >= 0);
+                }
+            });
+        }
+        for(auto& th: threads) {
+            th.join();
+        }
+        std::vector<ConnectionPool<Widget>::Lease> leases;
+        for(int i = 0; i < sum; i++) {
+            leases.emplace_back(cp.borrow());
+        }
+        assert(cp.empty() == true);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+/**
+ * 保守スレッドの確認。
+ * value が負の Widget を死んだコネクションに見立て、破棄と target までの補充が行われること。
+*/
+
+int test_ConnectionPool_maintenance() {
+    puts("=== test_ConnectionPool_maintenance");
+    try {
+        ConnectionPool<Widget> cp("Widget.", 2);
+        cp.push(new Widget(1));
+        cp.push(new Widget(-1));        // 死んでいる
+        cp.push(new Widget(3));
+        cp.startMaintenance([](Widget* w){ return w->getValue() >= 0; }
+                        , []{ return new Widget(100); }
+                        , 4
+                        , std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cp.stopMaintenance();
+        ptr_lambda_debug<const char*, const std::size_t&>("evicted count is ", cp.evictedCount());
+        assert(cp.evictedCount() == 1);
+        std::vector<ConnectionPool<Widget>::Lease> leases;
+        for(int i = 0; i < 4; i++) {
+            leases.emplace_back(cp.borrow());
+            assert(leases.back()->getValue() >= 0);
+        }
+        assert(cp.empty() == true);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_ConnectionPool_onEvict() {
+    puts("=== test_ConnectionPool_onEvict");
+    try {
+        std::set<int> notified;
+        std::mutex m;
+        {
+            ConnectionPool<Widget> cp("Widget.", 2);
+            cp.onEvict([&](const Widget* w) {
+                std::lock_guard<std::mutex> guard(m);
+                notified.insert(w->getValue());
+            });
+            cp.push(new Widget(1));
+            cp.push(new Widget(-1));        // 死んでいる
+            cp.startMaintenance([](Widget* w){ return w->getValue() >= 0; }
+                            , []{ return new Widget(100); }
+                            , 2
+                            , std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            cp.stopMaintenance();
+            std::lock_guard<std::mutex> guard(m);
+            assert(notified == std::set<int>({-1}));
+        }
+        // デストラクタで破棄したものも通知する
+        ptr_lambda_debug<const char*, const std::size_t&>("notified size is ", notified.size());
+        assert(notified == std::set<int>({-1, 1, 100}));
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+/**
+ * push と Lease::discard の確認。
+ * 貸し出し中に push した新しいオブジェクトは貸し出し中の数を減らさないこと。
+ * discard したものは破棄、通知され、貸し出し中から外れて refill で補充されること。
+*/
+
+int test_ConnectionPool_discard() {
+    puts("=== test_ConnectionPool_discard");
+    try {
+        std::set<int> notified;
+        ConnectionPool<Widget> cp("Widget.", 1);
+        cp.onEvict([&](const Widget* w) { notified.insert(w->getValue()); });
+        cp.push(new Widget(1));
+        ConnectionPool<Widget>::Lease lease = cp.borrow();
+        cp.push(new Widget(2));
+        assert(cp.borrowedCount() == 1);
+        lease.discard();
+        assert(!lease);
+        assert(cp.borrowedCount() == 0);
+        assert(cp.evictedCount() == 1);
+        assert(notified == std::set<int>({1}));
+        cp.startMaintenance([](Widget* w){ return w->getValue() >= 0; }
+                        , []{ return new Widget(100); }
+                        , 2
+                        , std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cp.stopMaintenance();
+        ConnectionPool<Widget>::Lease a = cp.borrow();
+        ConnectionPool<Widget>::Lease b = cp.borrow();
+        assert(cp.empty() == true);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+/**
+ * 統計の確認。
+*/
+
+int test_ConnectionPool_stats() {
+    puts("=== test_ConnectionPool_stats");
+    try {
+        ConnectionPool<Widget> cp("Widget.", 2);
+        cp.push(new Widget(1));
+        cp.push(new Widget(2));
+        {
+            ConnectionPool<Widget>::Lease a = cp.borrow();
+            ConnectionPool<Widget>::Lease b = cp.borrow();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            try {
+                ConnectionPool<Widget>::Lease c = cp.borrow(std::chrono::milliseconds(1));     // 枯渇、timeout
+            } catch(std::exception& e) {
+                ptr_print_error<const decltype(e)&>(e);
+            }
+        }
+        PoolStats st = cp.stats();
+        ptr_lambda_debug<const char*, const std::string&>("stats: ", st.toString());
+        assert(st.borrowTotal   == 2);
+        assert(st.borrowCurrent == 0);
+        assert(st.borrowPeak    == 2);
+        assert(st.exhaustion    == 1);
+        assert(st.timeouts      == 1);
+        assert(st.holdCount     == 2);
+        assert(st.holdP50       >= 2000);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+/**
+ * PoolRouter の確認、冒頭の read-only と更新系の Pool を分ける構想を primary とレプリカの振り分けとして実現したもの。
+ *
+ * - 読み取りはレプリカに、書き込みは primary に振り分けられること。
+ * - 書き込みの直後（RYW の window 内）は同じ RoutingSession の読み取りが primary になること。
+ * - レプリカが借りられない場合は primary に逃がすこと。
+*/
+
+int test_PoolRouter() {
+    puts("=== test_PoolRouter");
+    try {
+        ConnectionPool<Widget> primary("primary.", 1);
+        ConnectionPool<Widget> replica1("replica1.", 1);
+        ConnectionPool<Widget> replica2("replica2.", 1);
+        primary.push(new Widget(0));
+        replica1.push(new Widget(1));
+        replica2.push(new Widget(2));
+        PoolRouter<Widget> router(&primary, {&replica1, &replica2}, ReplicaSelect::ROUND_ROBIN, std::chrono::milliseconds(50));
+        RoutingSession session;
+        {
+            PoolRouter<Widget>::Route r1 = router.borrowFor<MySQLReadStrategy<PersonData, std::size_t>>(&session);
+            PoolRouter<Widget>::Route r2 = router.borrowFor<MySQLReadStrategy<PersonData, std::size_t>>(&session);
+            assert( !r1.isPrimary() && !r2.isPrimary() );
+            assert( r1->getValue() != r2->getValue() );         // ラウンドロビン
+            PoolRouter<Widget>::Route r3 = router.borrowRead(&session);
+            assert( r3.isPrimary() );                           // レプリカが空なので primary へ
+            assert( router.fallbackCount() == 1 );
+        }
+        {
+            PoolRouter<Widget>::Route w = router.borrowFor<MySQLUpdateStrategy<PersonData, std::size_t>>(&session);
+            assert( w.isPrimary() );
+        }
+        {
+            PoolRouter<Widget>::Route r = router.borrowRead(&session);
+            assert( r.isPrimary() );                            // RYW
+            assert( router.pinnedCount() == 1 );
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        {
+            PoolRouter<Widget>::Route r = router.borrowRead(&session);
+            assert( !r.isPrimary() );
+        }
+        assert( primary.borrowedCount() == 0 && replica1.borrowedCount() == 0 && replica2.borrowedCount() == 0 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
 
 
 extern ConnectionPool<sql::Connection> app_cp;
@@ -85,14 +357,14 @@ int test_mysql_connection_pool_A() {
         std::unique_ptr<sql::PreparedStatement> prep_stmt_1(mcon_1->prepareStatement(sql));
         // ... do something
         // コネクションの利用が終わったら返却する
-        app_cp.push(con_1);
+        app_cp.giveBack(con_1);
 
         sql::Connection* con_2 = app_cp.pop();
         ptr_lambda_debug<const char*, const sql::Connection*>("con_2 addr is ", con_2);
         std::unique_ptr<MySQLConnection> mcon_2 = std::make_unique<MySQLConnection>(con_2);
         std::unique_ptr<sql::PreparedStatement> prep_stmt_2(mcon_2->prepareStatement(sql));
         // ... do something
-        app_cp.push(con_2);
+        app_cp.giveBack(con_2);
 
         /**
          * これを踏まえて テスト B を行ってみる。
@@ -116,14 +388,14 @@ int test_mysql_connection_pool_B() {
         std::unique_ptr<sql::PreparedStatement> prep_stmt_1(mcon_1->prepareStatement(sql));
         // ... do something
         // コネクションの利用が終わったら返却する
-        app_cp.push(con_1);
+        app_cp.giveBack(con_1);
 
         sql::Connection* con_2 = app_cp.pop();
         ptr_lambda_debug<const char*, const sql::Connection*>("con_2 addr is ", con_2);
         std::unique_ptr<MySQLConnection> mcon_2 = std::make_unique<MySQLConnection>(con_2);
         std::unique_ptr<sql::PreparedStatement> prep_stmt_2(mcon_2->prepareStatement(sql));
         // ... do something
-        app_cp.push(con_2);
+        app_cp.giveBack(con_2);
         /**
          * テスト A、B でコネクションのアドレスが同じであることが重要。
          * 返却するタイミングでは、前後は異なると考える（ConnectionPool の内部では std::queue を利用している）。
@@ -136,6 +408,33 @@ int test_mysql_connection_pool_B() {
     }
 }
 
+/**
+ * Prepared Statement キャッシュの確認。
+ * 同じ SQL では同じ Statement が再利用され、上限を超えると古いものから追い出されること。
+*/
+
+int test_MySQLConnection_statement_cache() {
+    puts("=== test_MySQLConnection_statement_cache");
+    try {
+        ConnectionPool<sql::Connection>::Lease lease = app_cp.borrow(std::chrono::milliseconds(100));
+        MySQLConnection mcon(lease.get(), 2);
+        std::string sql_1("SELECT id, name, email, age FROM person WHERE id = ?");
+        std::string sql_2("SELECT id, name FROM person WHERE id = ?");
+        std::string sql_3("SELECT id, email FROM person WHERE id = ?");
+        sql::PreparedStatement* prep_stmt_1 = mcon.prepareCachedStatement(sql_1);
+        sql::PreparedStatement* prep_stmt_2 = mcon.prepareCachedStatement(sql_1);
+        assert(prep_stmt_1 == prep_stmt_2);
+        assert(mcon.cachedStatementCount() == 1);
+        mcon.prepareCachedStatement(sql_2);
+        mcon.prepareCachedStatement(sql_3);         // sql_1 が追い出される
+        assert(mcon.cachedStatementCount() == 2);
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 /**
  * うん、分かったようなそうでもないような感じなのだが。
  * 
@@ -238,7 +537,7 @@ int test_MySQLTx() {
         MySQLTx tx(mcon.get(), proc_strategy.get());
         std::optional<PersonData> after = tx.executeTx();
         if(rawCon) {
-            app_cp.push(rawCon);
+            app_cp.giveBack(rawCon);
         }
         // 検査
         assert(after.has_value() == true);
@@ -319,7 +618,7 @@ int test_MySQLTx_Create(std::size_t* insId) {
             std::optional<PersonData> after = tx.executeTx();
             // この仕組みは再考の余地がある、エラーが起きた時は、誰がどこで、コネクションを返却するのか？
             if(rawCon) {
-                app_cp.push(rawCon);
+                app_cp.giveBack(rawCon);
             }
             // 検査
             assert(after.has_value() == true);
@@ -365,7 +664,7 @@ int test_MySQLTx_Read(std::size_t* insId) {
             std::optional<PersonData> after = tx.executeTx();
             // この仕組みは再考の余地がある、エラーが起きた時は、誰がどこで、コネクションを返却するのか？
             if(rawCon) {
-                app_cp.push(rawCon);
+                app_cp.giveBack(rawCon);
             }
             // 検証
             assert(after.has_value() == true);
@@ -412,7 +711,7 @@ int test_MySQLTx_Update(std::size_t* insId) {
             std::optional<PersonData> after = tx.executeTx();
             // この仕組みは再考の余地がある、エラーが起きた時は、誰がどこで、コネクションを返却するのか？
             if(rawCon) {
-                app_cp.push(rawCon);
+                app_cp.giveBack(rawCon);
             }
 
             // 検証
@@ -461,7 +760,7 @@ int test_MySQLTx_Delete(std::size_t* insId) {
             std::optional<PersonData> after = tx_r.executeTx();
             // この仕組みは再考の余地がある、エラーが起きた時は、誰がどこで、コネクションを返却するのか？
             if(rawCon) {
-                app_cp.push(rawCon);
+                app_cp.giveBack(rawCon);
             }
             assert(after.has_value() == false);
         } else {
@@ -474,6 +773,65 @@ int test_MySQLTx_Delete(std::size_t* insId) {
     } 
 }
 
+int test_TxExecutor() {
+    puts("=== test_TxExecutor");
+    try {
+        if(!app_cp.empty()) {
+            std::clock_t start = clock();
+            // 4 つの独立したトランザクションを同時に投入する、worker はそれぞれ app_cp のコネクションを 1 つ保持する
+            TxExecutor<PersonData, sql::Connection, MySQLConnection> executor(&app_cp, 2, 8
+                , [](MySQLConnection* con, const RdbProcStrategy<PersonData>* strategy) {
+                    return std::make_unique<MySQLTx<PersonData>>(con, strategy);
+                }
+                , std::chrono::milliseconds(100)
+                , [](sql::Connection* con) { return con->isValid(); });     // 一意制約違反ではコネクションを破棄しない
+            std::vector<std::string> names{"Ector", "Floyd", "Gale", "Hobbs"};
+            std::vector<std::future<std::optional<PersonData>>> futures;
+            for(const std::string& n: names) {
+                PersonData data = PersonData::factory(n, n + "@tx.executor.org", 33, nullptr);
+                futures.push_back(executor.submit([data](MySQLConnection* con) {
+                    PersonRepository repo(con);
+                    return MySQLCreateStrategy<PersonData, std::size_t>(&repo, data).proc();
+                }));
+            }
+            // 一意制約に抵触するものは rollback され、future から例外として受け取る
+            std::future<std::optional<PersonData>> dup = executor.submit([](MySQLConnection* con) {
+                PersonRepository repo(con);
+                PersonData data = PersonData::factory("Ector2", "Ector@tx.executor.org", nullptr);
+                return MySQLCreateStrategy<PersonData, std::size_t>(&repo, data).proc();
+            });
+            std::vector<std::size_t> ids;
+            for(std::size_t i = 0; i < futures.size(); i++) {
+                std::optional<PersonData> after = futures[i].get();
+                assert( after.has_value() );
+                assert( after.value().getName().getValue() == names[i] );
+                ids.push_back(after.value().getId().getValue());
+            }
+            bool thrown = false;
+            try {
+                dup.get();
+            } catch(std::exception& e) {
+                thrown = true;
+            }
+            assert( thrown );
+            // 後始末も executor で行う
+            executor.submit([ids](MySQLConnection* con) -> std::optional<PersonData> {
+                PersonRepository repo(con);
+                for(const std::size_t& id: ids) {
+                    repo.remove(id);
+                }
+                return std::nullopt;
+            }).get();
+            std::clock_t end = clock();
+            std::cout << "passed " << (double)(end-start)/CLOCKS_PER_SEC << " sec." << std::endl;
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 /**
  * MySQL X DevAPI
  * 以前利用した mysqlx を再度検証してみる。
@@ -705,6 +1063,60 @@ int test_DataField_3() {
     }
 }
 
+int test_DataField_meta() {
+    puts("=== test_DataField_meta");
+    try {
+        DataField<std::string> n1("name", "Derek");
+        DataField<std::string> n2("name", "Cheshire");
+        DataField<int>         d1("id", 3, "integer", "PRIMARY KEY");
+        // 同じ名前、型、制約のメタ情報は共有される（行ごとに文字列を持たない）
+        assert( n1.getMeta() == n2.getMeta() );
+        assert( n1.getMeta() != d1.getMeta() );
+        assert( &n1.getName() == &n2.getName() );
+        assert( sizeof(DataField<int>) <= sizeof(void*) * 2 );
+        // 結果セットから作った行は PersonData のスキーマのメタ情報を指す
+        PersonData p = PersonData::factory("Derek", "derek@loki.org", 21, nullptr);
+        assert( p.getName().getMeta() == PersonData::schema().name );
+        assert( p.getName().getMeta() == n1.getMeta() );
+        assert( &p.getTableName() == &PersonData::schema().tableName );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_DataField_move() {
+    puts("=== test_DataField_move");
+    try {
+        // SSO に収まらない長さにして、確保したバッファがそのまま引き継がれる（コピーされない）ことをアドレスで確かめる
+        std::string name(64, 'n');
+        std::string email(64, 'e');
+        const char* pName  = name.data();
+        const char* pEmail = email.data();
+        DataField<std::string> f(PersonData::schema().name, std::move(name));
+        assert( f.getValue().data() == pName );
+        PersonData p(nullptr, std::move(f), DataField<std::string>(PersonData::schema().email, std::move(email)), std::nullopt);
+        assert( p.getName().getValue().data()  == pName );
+        assert( p.getEmail().getValue().data() == pEmail );
+        // factory も同じ
+        std::string name2(64, 'm');
+        const char* pName2 = name2.data();
+        PersonData p2 = PersonData::factory(std::move(name2), std::string(64, 'f'), 21, nullptr);
+        assert( p2.getName().getValue().data() == pName2 );
+        // ormx::PersonData の getter は参照を返す
+        std::string name3(64, 'x');
+        const char* pName3 = name3.data();
+        ormx::PersonData x(std::move(name3), "x@loki.org", 30);
+        assert( x.getName().data() == pName3 );
+        assert( &x.getName() == &x.getName() );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 int test_PersonData() {
     puts("=== test_PersonData");
     try {
@@ -773,6 +1185,14 @@ int test_makeInsertSql() {
 
         auto sql2 = makeInsertSql(cheshire.getTableName(), cheshire.getColumns());
         ptr_lambda_debug<const char*,const decltype(sql2)&>("sql2: ", sql2);
+
+        auto sql3 = makeInsertSql(derek.getTableName(), derek.getColumns(), 3);        // 複数行
+        ptr_lambda_debug<const char*,const decltype(sql3)&>("sql3: ", sql3);
+        assert(sql3 == "INSERT INTO person (name, email, age) VALUES (?, ?, ?), (?, ?, ?), (?, ?, ?)");
+
+        auto sql4 = makeFindByIdsSql(derek.getTableName(), "id", derek.getColumns(), 3);
+        ptr_lambda_debug<const char*,const decltype(sql4)&>("sql4: ", sql4);
+        assert(sql4 == "SELECT id, name, email, age FROM person WHERE id IN (?, ?, ?)");
         return EXIT_SUCCESS;
     } catch(std::exception& e) {
         ptr_print_error<const decltype(e)&>(e);
@@ -837,6 +1257,82 @@ int test_makeFindOneSql() {
     }
 }
 
+int test_makeUpsertSql() {
+    puts("=== test_makeUpsertSql");
+    try {
+        const std::vector<std::string> cols = PersonData::TABLE.columnNames(1u);
+        auto sql = makeUpsertSql(PersonData::schema().tableName, "id", cols);
+        ptr_lambda_debug<const char*, const decltype(sql)&>("sql: ", sql);
+        assert(sql == "INSERT INTO person (id, name, email, age) VALUES (?, ?, ?, ?) AS new ON DUPLICATE KEY UPDATE id = LAST_INSERT_ID(id), name = new.name, email = new.email, age = new.age");
+        auto sql2 = makeUpsertSql(PersonData::schema().tableName, "id", cols, 2);      // 複数行
+        ptr_lambda_debug<const char*, const decltype(sql2)&>("sql2: ", sql2);
+        assert(sql2 == "INSERT INTO person (id, name, email, age) VALUES (?, ?, ?, ?), (?, ?, ?, ?) AS new ON DUPLICATE KEY UPDATE id = LAST_INSERT_ID(id), name = new.name, email = new.email, age = new.age");
+        auto sql3 = makePgUpsertSql("company", "id", {"name", "address"}, 2);         // PostgreSQL
+        ptr_lambda_debug<const char*, const decltype(sql3)&>("sql3: ", sql3);
+        assert(sql3 == "INSERT INTO company (id, name, address) VALUES ($1, $2, $3), ($4, $5, $6) ON CONFLICT (id) DO UPDATE SET name = EXCLUDED.name, address = EXCLUDED.address");
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_TableDef() {
+    puts("=== test_TableDef");
+    try {
+        // SQL とバインド位置はコンパイル時に決まる
+        static_assert( PersonSql::VARIANTS == 2 );
+        static_assert( PersonSql::insert[1].view() == "INSERT INTO person (name, email, age) VALUES (?, ?, ?)" );
+        static_assert( PersonSql::insert[0].view() == "INSERT INTO person (name, email) VALUES (?, ?)" );
+        static_assert( PersonSql::update[0].view() == "UPDATE person SET name = ?, email = ? WHERE id = ?" );
+        static_assert( PersonData::TABLE.bindIndex(PersonData::COL_AGE, 1) == 3 );
+        static_assert( PersonData::TABLE.bindIndex(PersonData::COL_AGE, 0) == 0 );
+        static_assert( PersonData::TABLE.pkeyBindIndex(1) == 4 );
+        static_assert( PersonData::TABLE.pkeyBindIndex(0) == 3 );
+        ptr_lambda_debug<const char*, const std::string_view&>("sql: ", PersonSql::update[1].view());
+        assert( PersonSql::update[1].view() == "UPDATE person SET name = ?, email = ?, age = ? WHERE id = ?" );
+        assert( PersonSql::findOne.view() == "SELECT id, name, email, age FROM person WHERE id = ?" );
+        assert( PersonSql::findAll.view() == "SELECT id, name, email, age FROM person" );
+        assert( PersonSql::remove.view() == "DELETE FROM person WHERE id = ?" );
+        // 従来の RdbDataStrategy と同じカラムを返す
+        PersonStrategy strategy;
+        PersonData derek   = PersonData::factory("Derek", "derek@loki.org", 21, &strategy);
+        PersonData cheshire = PersonData::factory("Cheshire", "cheshire@loki.org", &strategy);
+        assert( derek.getColumns() == (std::vector<std::string>{"name", "email", "age"}) );
+        assert( cheshire.getColumns() == (std::vector<std::string>{"name", "email"}) );
+        assert( PersonData::TABLE.tableInfo().size() == 4 );
+        assert( std::get<0>(PersonData::TABLE.tableInfo()[0]) == "id" );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_bulk_appendRow() {
+    puts("=== test_bulk_appendRow");
+    try {
+        // LOAD DATA の既定の書式、区切り文字と \ はエスケープ、NULL は \N
+        auto desc = makeBulkDescriptor<PersonData>("person", {"name", "email", "age"}
+            , [](const PersonData& d) -> const std::string& { return d.getName().getValue(); }
+            , [](const PersonData& d) -> const std::string& { return d.getEmail().getValue(); }
+            , [](const PersonData& d) -> std::optional<int> {
+                return d.getAge().has_value() ? std::optional<int>(d.getAge().value().getValue()) : std::nullopt;
+            });
+        std::string buf;
+        bulk::appendRow(buf, desc, PersonData::factory("Derek", "derek@loki.org", 21, nullptr));
+        bulk::appendRow(buf, desc, PersonData::factory("Tab\tName\\", "line\nbreak@loki.org", nullptr));
+        ptr_lambda_debug<const char*, const std::string&>("buf: ", buf);
+        assert( buf == "Derek\tderek@loki.org\t21\nTab\\tName\\\\\tline\\nbreak@loki.org\t\\N\n" );
+        BulkLoadReport report{1000, 1, std::chrono::milliseconds(500)};
+        assert( report.rowsPerSec() == 2000.0 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 int test_makeCreateTableSql() {
     puts("=== test_makeCreateTableSql");
     try {
@@ -1123,6 +1619,272 @@ int test_PersonRepository_insert_no_age() {
     }
 }
 
+int test_PersonRepository_insertMany() {
+    puts("=== test_PersonRepository_insertMany");
+    try {
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con = std::move(std::unique_ptr<sql::Connection>(driver->connect(appProp.my.toServer(), appProp.my.user, appProp.my.password)));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            std::unique_ptr<RdbDataStrategy<PersonData>> strategy = std::make_unique<PersonStrategy>(PersonStrategy());
+            const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+            std::vector<PersonData> datas;
+            for(int i = 0; i < 5; i++) {
+                std::string name  = "cheshire_many_" + std::to_string(i);
+                std::string email = name + "_" + suffix + "@loki.org";
+                if(i % 2 == 0) {
+                    datas.emplace_back(PersonData::factory(name, email, i, strategy.get()));
+                } else {
+                    datas.emplace_back(PersonData::factory(name, email, strategy.get()));      // age なし（NULL）
+                }
+            }
+            std::unique_ptr<Repository<PersonData,std::size_t>> repo = std::make_unique<PersonRepository>(mcon.get());
+            std::vector<std::size_t> keys = repo->insertMany(datas, 2);     // 2 行、2 行、1 行の 3 チャンク
+            assert(keys.size() == datas.size());
+            for(std::size_t i = 0; i < keys.size(); i++) {
+                std::optional<PersonData> opt = repo->findOne(keys[i]);
+                assert(opt.has_value() == true);
+                if(opt.has_value()) {
+                    assert(datas[i].getEmail().getValue() == opt.value().getEmail().getValue());
+                }
+            }
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_PersonRepository_upsert() {
+    puts("=== test_PersonRepository_upsert");
+    try {
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con = std::move(std::unique_ptr<sql::Connection>(driver->connect(appProp.my.toServer(), appProp.my.user, appProp.my.password)));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            std::unique_ptr<RdbDataStrategy<PersonData>> strategy = std::make_unique<PersonStrategy>(PersonStrategy());
+            const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+            const std::string email = "upsert_" + suffix + "@loki.org";
+            std::unique_ptr<Repository<PersonData,std::size_t>> repo = std::make_unique<PersonRepository>(mcon.get());
+            // 無ければ登録
+            std::optional<PersonData> first = repo->upsert(PersonData::factory("upsert", email, 20, strategy.get()));
+            assert(first.has_value() == true);
+            const std::size_t id = first.value().getId().getValue();
+            assert(id != 0);
+            // email（UNIQUE）が同じなら、同じ行を更新する（id は 0 のまま渡しても同じキーが返る）
+            std::optional<PersonData> second = repo->upsert(PersonData::factory("upsert2", email, 21, strategy.get()));
+            assert(second.has_value() == true);
+            assert(second.value().getId().getValue() == id);
+            std::optional<PersonData> found = repo->findOne(id);
+            assert(found.has_value() == true && found.value().getName().getValue() == "upsert2");
+            assert(found.value().getAge().value().getValue() == 21);
+            // 一括版、既存の行の更新と新規の登録が混在してよい
+            std::vector<PersonData> datas;
+            datas.emplace_back(PersonData::factory("upsert3", email, strategy.get()));                           // 更新（age は NULL）
+            datas.emplace_back(PersonData::factory("upsert_many", "upsert_many_" + suffix + "@loki.org", 30, strategy.get()));      // 登録
+            repo->upsertMany(datas);
+            found = repo->findOne(id);
+            assert(found.has_value() == true && found.value().getName().getValue() == "upsert3");
+            assert(found.value().getAge().has_value() == false);
+            // 採番した登録の後に、新しいキーを明示して登録する（LAST_INSERT_ID() は更新されない）
+            const std::size_t explicitId = id + 1000000;
+            for(const ResultPolicy& policy: {ResultPolicy::DEFAULT, ResultPolicy::REFETCH}) {
+                PersonRepository explicitRepo(mcon.get(), policy);
+                const std::size_t key = explicitId + static_cast<std::size_t>(policy == ResultPolicy::REFETCH);
+                const std::string explicitEmail = "upsert_explicit_" + std::to_string(key) + "_" + suffix + "@loki.org";
+                std::optional<PersonData> inserted = explicitRepo.upsert(PersonData(strategy.get()
+                    , DataField<std::size_t>(PersonData::schema().id, key)
+                    , DataField<std::string>("name", "upsert_explicit")
+                    , DataField<std::string>("email", explicitEmail)
+                    , DataField<int>("age", 40)));
+                assert(inserted.has_value() == true);
+                assert(inserted.value().getId().getValue() == key);
+                assert(inserted.value().getEmail().getValue() == explicitEmail);
+                repo->remove(key);
+            }
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+int test_PersonRepository_bulkLoad() {
+    puts("=== test_PersonRepository_bulkLoad");
+    try {
+        // LOAD DATA LOCAL INFILE はコネクションの OPT_LOCAL_INFILE が必要
+        sql::ConnectOptionsMap options;
+        options["hostName"]         = appProp.my.toServer();
+        options["userName"]         = appProp.my.user;
+        options["password"]         = appProp.my.password;
+        options["OPT_LOCAL_INFILE"] = 1;
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con(driver->connect(options));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+            std::vector<PersonData> datas;
+            for(int i = 0; i < 1000; i++) {
+                std::string name  = "cheshire_bulk_" + std::to_string(i);
+                std::string email = name + "_" + suffix + "@loki.org";
+                if(i % 2 == 0) {
+                    datas.emplace_back(PersonData::factory(name, email, i % 100, nullptr));
+                } else {
+                    datas.emplace_back(PersonData::factory(name, email, nullptr));      // age なし（NULL）
+                }
+            }
+            PersonRepository repo(mcon.get());
+            mcon->begin();
+            BulkLoadReport report = repo.bulkLoad(datas, 300);      // 300 行ずつ 4 回
+            mcon->commit();
+            ptr_lambda_debug<const char*, const double&>("rows/sec is ", report.rowsPerSec());
+            assert(report.rows == datas.size());
+            assert(report.batches == 4);
+            // 同じ email（UNIQUE）は拒否され、例外になる
+            bool thrown = false;
+            try {
+                mcon->begin();
+                repo.bulkLoad(std::span<const PersonData>(datas).first(1));
+                mcon->commit();
+            } catch(std::exception& e) {
+                mcon->rollback();
+                thrown = true;
+            }
+            assert(thrown);
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_PersonRepository_ResultPolicy() {
+    puts("=== test_PersonRepository_ResultPolicy");
+    try {
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con = std::move(std::unique_ptr<sql::Connection>(driver->connect(appProp.my.toServer(), appProp.my.user, appProp.my.password)));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            std::unique_ptr<RdbDataStrategy<PersonData>> strategy = std::make_unique<PersonStrategy>(PersonStrategy());
+            const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+            PersonData data_1 = PersonData::factory("policy_1", "policy_1_" + suffix + "@loki.org", 1, strategy.get());
+            PersonData data_2 = PersonData::factory("policy_2", "policy_2_" + suffix + "@loki.org", 2, strategy.get());
+            PersonData data_3 = PersonData::factory("policy_3", "policy_3_" + suffix + "@loki.org", 3, strategy.get());
+
+            PersonRepository noEcho(mcon.get(), ResultPolicy::NO_ECHO);
+            assert(noEcho.insert(data_1).has_value() == false);      // 書き込みのみ
+
+            PersonRepository echo(mcon.get(), ResultPolicy::ECHO);
+            std::optional<PersonData> opt_2 = echo.insert(data_2);
+            assert(opt_2.has_value() == true);
+            if(opt_2.has_value()) {
+                assert(opt_2.value().getId().getValue() > 0);
+                opt_2.value().setName(DataField<std::string>("name", "policy_2_updated"));
+                opt_2.value().setDataStrategy(strategy.get());
+                std::optional<PersonData> upd = echo.update(opt_2.value());     // findOne しない
+                assert(upd.has_value() == true);
+                assert(upd.value().getName().getValue() == "policy_2_updated");
+            }
+
+            PersonRepository refetch(mcon.get(), ResultPolicy::REFETCH);
+            std::optional<PersonData> opt_3 = refetch.insert(data_3);
+            assert(opt_3.has_value() == true);
+            if(opt_3.has_value()) {
+                assert(opt_3.value().getEmail().getValue() == data_3.getEmail().getValue());
+            }
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_PersonRepository_findByIds() {
+    puts("=== test_PersonRepository_findByIds");
+    try {
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con = std::move(std::unique_ptr<sql::Connection>(driver->connect(appProp.my.toServer(), appProp.my.user, appProp.my.password)));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            std::unique_ptr<RdbDataStrategy<PersonData>> strategy = std::make_unique<PersonStrategy>(PersonStrategy());
+            const std::string suffix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+            std::vector<PersonData> datas;
+            datas.emplace_back(PersonData::factory("find_1", "find_1_" + suffix + "@loki.org", 1, strategy.get()));
+            datas.emplace_back(PersonData::factory("find_2", "find_2_" + suffix + "@loki.org", strategy.get()));
+            std::unique_ptr<Repository<PersonData,std::size_t>> repo = std::make_unique<PersonRepository>(mcon.get());
+            std::vector<std::size_t> keys = repo->insertMany(datas);
+            assert(keys.size() == 2);
+            const std::size_t notFound = 0;                 // AUTO_INCREMENT は 1 から
+            std::vector<std::size_t> pkeys = {keys[1], notFound, keys[0], keys[1]};
+            FindResult<PersonData, std::size_t> result = repo->findByIds(pkeys);
+            assert(result.rows.size() == pkeys.size());
+            assert(result.rows[0].has_value() == true && result.rows[0].value().getName().getValue() == "find_2");
+            assert(result.rows[0].value().getAge().has_value() == false);
+            assert(result.rows[1].has_value() == false);
+            assert(result.rows[2].has_value() == true && result.rows[2].value().getName().getValue() == "find_1");
+            assert(result.rows[3].has_value() == true && result.rows[3].value().getId().getValue() == keys[1]);
+            assert(result.missing.size() == 1 && result.missing[0] == notFound);
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_PersonRepository_findAll() {
+    puts("=== test_PersonRepository_findAll");
+    try {
+        sql::Driver* driver = MySQLDriver::getInstance().getDriver();
+        std::unique_ptr<sql::Connection> con = std::move(std::unique_ptr<sql::Connection>(driver->connect(appProp.my.toServer(), appProp.my.user, appProp.my.password)));
+        if(con->isValid()) {
+            puts("connected ... ");
+            con->setSchema("cheshire");
+            std::unique_ptr<MySQLConnection> mcon = std::make_unique<MySQLConnection>(con.get());
+            std::unique_ptr<Repository<PersonData,std::size_t>> repo = std::make_unique<PersonRepository>(mcon.get());
+            std::size_t count = 0;
+            std::size_t prev  = 0;
+            for(const PersonData& p: repo->findAll(2)) {       // 2 行ずつ受け取る、保持するのは常に 1 行
+                assert(p.getId().getValue() > 0);
+                assert(p.getId().getValue() != prev);
+                prev = p.getId().getValue();
+                count++;
+            }
+            ptr_lambda_debug<const char*, const std::size_t&>("count is ", count);
+            assert(count > 0);                                  // 先行するテストで登録済み
+        } else {
+            throw std::runtime_error("Invalid connection.");
+        }
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
 int test_PersonRepository_remove() {
     puts("=== test_PersonRepository_remove");
     try {
@@ -1148,3 +1910,316 @@ int test_PersonRepository_remove() {
         return EXIT_FAILURE;
     }
 }
+
+/**
+ * IdentityMapRepository の確認、サーバの代わりにメモリ上の Repository を包み、問い合わせの回数を数える。
+*/
+
+class MemoryRepository final : public Repository<std::pair<std::size_t, std::string>, std::size_t> {
+public:
+    using Row = std::pair<std::size_t, std::string>;
+    virtual std::optional<Row> insert(const Row& data) const override {
+        const std::size_t id = ++seq;
+        rows[id] = data.second;
+        return Row(id, data.second);
+    }
+    virtual std::optional<Row> update(const Row& data) const override {
+        rows[data.first] = data.second;
+        return data;
+    }
+    virtual void remove(const std::size_t& pkey) const override {
+        rows.erase(pkey);
+    }
+    virtual std::optional<Row> findOne(const std::size_t& pkey) const override {
+        reads++;
+        auto it = rows.find(pkey);
+        return it == rows.end() ? std::nullopt : std::optional<Row>(*it);
+    }
+    virtual std::vector<std::size_t> insertMany(std::span<const Row> datas, const std::size_t&) const override {
+        std::vector<std::size_t> ids;
+        for(const Row& d: datas) {
+            ids.push_back(insert(d).value().first);
+        }
+        return ids;
+    }
+    virtual std::optional<Row> upsert(const Row& data) const override {
+        if(rows.find(data.first) != rows.end()) {
+            return update(data);
+        }
+        return insert(data);
+    }
+    virtual void upsertMany(std::span<const Row> datas, const std::size_t&) const override {
+        for(const Row& d: datas) {
+            upsert(d);
+        }
+    }
+    virtual FindResult<Row, std::size_t> findByIds(std::span<const std::size_t> pkeys, const std::size_t& chunkSize) const override {
+        return findByIdsChunked(pkeys, chunkSize, [this](std::span<const std::size_t> chunk) {
+            reads++;
+            std::vector<std::pair<std::size_t, Row>> found;
+            for(const std::size_t& k: chunk) {
+                auto it = rows.find(k);
+                if(it != rows.end()) {
+                    found.emplace_back(k, *it);
+                }
+            }
+            return found;
+        });
+    }
+    virtual Cursor<Row> findAll(const std::size_t&) const override {
+        return Cursor<Row>([it = rows.begin(), this]() mutable -> std::optional<Row> {
+            return it == rows.end() ? std::nullopt : std::optional<Row>(*it++);
+        });
+    }
+    mutable std::size_t reads = 0;        // サーバへの往復の代わり
+private:
+    mutable std::map<std::size_t, std::string> rows;
+    mutable std::size_t seq = 0;
+};
+
+int test_IdentityMapRepository() {
+    puts("=== test_IdentityMapRepository");
+    try {
+        using Row = MemoryRepository::Row;
+        MemoryRepository memory;
+        const std::size_t alice = memory.insert(Row(0, "Alice")).value().first;
+        const std::size_t bob   = memory.insert(Row(0, "Bob")).value().first;
+        IdentityMapRepository<Row, std::size_t> uow(&memory, [](const Row& r) { return r.first; });
+        // 同じキーの 2 回目以降はサーバに問い合わせない
+        assert( uow.findOne(alice).value().second == "Alice" );
+        assert( uow.findOne(alice).value().second == "Alice" );
+        assert( memory.reads == 1 );
+        // update の結果で置き換わる
+        uow.update(Row(alice, "Alice2"));
+        assert( uow.findOne(alice).value().second == "Alice2" );
+        assert( memory.reads == 1 );
+        // findByIds は保持していないものだけを問い合わせる、存在しないことも保持する
+        std::vector<std::size_t> ids{alice, bob, 99, bob};
+        FindResult<Row, std::size_t> found = uow.findByIds(ids);
+        assert( memory.reads == 2 );
+        assert( found.rows.size() == 4 && found.rows[1].value().second == "Bob" && !found.rows[2].has_value() );
+        assert( found.missing == std::vector<std::size_t>{99} );
+        assert( !uow.findOne(99).has_value() );
+        assert( memory.reads == 2 );
+        // remove 後は存在しない
+        uow.remove(bob);
+        assert( !uow.findOne(bob).has_value() );
+        assert( memory.reads == 2 );
+        ptr_lambda_debug<const char*, const std::size_t&>("hitCount is ", uow.hitCount());
+        ptr_lambda_debug<const char*, const std::size_t&>("missCount is ", uow.missCount());
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_IdentityMapRepository_upsert() {
+    puts("=== test_IdentityMapRepository_upsert");
+    try {
+        using Row = MemoryRepository::Row;
+        MemoryRepository memory;
+        IdentityMapRepository<Row, std::size_t> uow(&memory, [](const Row& r) { return r.first; });
+        // 無ければ登録、あれば更新、結果は保持される
+        const std::size_t alice = uow.upsert(Row(0, "Alice")).value().first;
+        assert( uow.upsert(Row(alice, "Alice2")).value().first == alice );
+        assert( uow.findOne(alice).value().second == "Alice2" );
+        assert( memory.reads == 0 );
+        // upsertMany の後は保持しているものを使わない
+        std::vector<Row> rows{Row(alice, "Alice3"), Row(0, "Bob")};
+        uow.upsertMany(rows);
+        assert( uow.findOne(alice).value().second == "Alice3" );
+        assert( memory.reads == 1 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+int test_CachedRepository() {
+    puts("=== test_CachedRepository");
+    try {
+        using Row = MemoryRepository::Row;
+        MemoryRepository memory;
+        const std::size_t alice = memory.insert(Row(0, "Alice")).value().first;
+        const std::size_t bob   = memory.insert(Row(0, "Bob")).value().first;
+        const std::size_t carol = memory.insert(Row(0, "Carol")).value().first;
+        RepositoryCache<Row, std::size_t> cache(2, std::chrono::milliseconds(50), 1);      // 容量 2、TTL 50 ミリ秒
+        CachedRepository<Row, std::size_t> cached(&memory, &cache, [](const Row& r) { return r.first; });
+        // MySQLReadStrategy にそのまま渡せる
+        MySQLReadStrategy<Row, std::size_t> read(&cached, alice);
+        assert( read.proc().value().second == "Alice" );
+        assert( read.proc().value().second == "Alice" );
+        assert( memory.reads == 1 );
+        // update は破棄する、afterTx() までは commit 前の行をキャッシュに入れない
+        cached.update(Row(alice, "Alice2"));
+        assert( cache.size() == 0 );
+        assert( cached.findOne(alice).value().second == "Alice2" );
+        assert( cache.size() == 0 );
+        assert( memory.reads == 2 );
+        cached.afterTx();
+        assert( cached.findOne(alice).value().second == "Alice2" );
+        assert( cached.findOne(alice).value().second == "Alice2" );
+        assert( memory.reads == 3 );
+        // 書き込みから afterTx() までに他のスレッドが入れた古い行も捨てる
+        cached.remove(alice);
+        cache.put(alice, Row(alice, "Alice2"));
+        cached.afterTx();
+        assert( !cached.findOne(alice).has_value() );
+        assert( memory.reads == 4 );
+        // findByIds の結果はキャッシュに入れない
+        std::vector<std::size_t> ids{bob, carol};
+        assert( cached.findByIds(std::span<const std::size_t>(ids)).rows.size() == 2 );
+        assert( cache.size() == 0 );
+        assert( memory.reads == 5 );
+        // LRU、容量 2 を超えると最も古いものを追い出す
+        cached.findOne(bob);
+        cached.findOne(carol);
+        cached.findOne(bob);
+        assert( cache.size() == 2 );
+        assert( memory.reads == 7 );
+        // TTL
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        cached.findOne(bob);
+        assert( memory.reads == 8 );
+        assert( cache.stats().expired == 1 );
+        // single-flight、同じキーの同時の取得は 1 回だけ問い合わせる
+        RepositoryCache<Row, std::size_t> shared(100, std::chrono::seconds(10));
+        std::atomic<int> loads{0};
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 8; i++) {
+            threads.emplace_back([&shared, &loads] {
+                std::optional<Row> row = shared.getOrLoad(7, [&loads] {
+                    loads.fetch_add(1);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    return std::optional<Row>(Row(7, "Seven"));
+                });
+                assert( row.value().second == "Seven" );
+            });
+        }
+        for(std::thread& t: threads) {
+            t.join();
+        }
+        CacheStats st = shared.stats();
+        ptr_lambda_debug<const char*, const int&>("loads is ", loads.load());
+        ptr_lambda_debug<const char*, const std::size_t&>("coalesced is ", st.coalesced);
+        assert( loads.load() == 1 );
+        assert( st.hits + st.coalesced == 7 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_IdBlockAllocator() {
+    puts("=== test_IdBlockAllocator");
+    try {
+        // シーケンスの代わり、予約の回数を数える
+        std::atomic<long>        seq{0};
+        std::atomic<std::size_t> reserved{0};
+        IdBlockAllocator<long> ids([&](const std::size_t& n) {
+            std::vector<long> block;
+            for(std::size_t i = 0; i < n; i++) {
+                block.push_back(++seq);
+            }
+            reserved++;
+            return block;
+        }, 64);
+        std::vector<std::thread> threads;
+        std::vector<std::vector<long>> got(4);
+        for(std::size_t t = 0; t < got.size(); t++) {
+            threads.emplace_back([&ids, &got, t] {
+                for(int i = 0; i < 500; i++) {
+                    got[t].push_back(ids.next());
+                }
+                std::vector<long> many = ids.next(100);       // 1 ブロックを超える
+                got[t].insert(got[t].end(), many.begin(), many.end());
+            });
+        }
+        for(std::thread& th: threads) {
+            th.join();
+        }
+        std::set<long> unique;
+        for(const std::vector<long>& g: got) {
+            unique.insert(g.begin(), g.end());
+        }
+        ptr_lambda_debug<const char*, const std::size_t&>("refill count is ", ids.refillCount());
+        ptr_lambda_debug<const char*, const std::size_t&>("stall count is ", ids.stallCount());
+        assert( unique.size() == 4 * 600 );
+        assert( ids.refillCount() == reserved.load() );
+        assert( ids.refillCount() * 64 >= 4 * 600 );
+
+        // 予約の失敗は next() に例外で返し、次の next() で再び予約する
+        std::atomic<int> calls{0};
+        IdBlockAllocator<long> flaky([&](const std::size_t&) -> std::vector<long> {
+            if(calls++ == 0) {
+                throw std::runtime_error("sequence is unavailable.");
+            }
+            return {100, 101};
+        }, 2);
+        bool thrown = false;
+        try {
+            flaky.next();
+        } catch(std::exception& e) {
+            ptr_print_error<const decltype(e)&>(e);
+            thrown = true;
+        }
+        assert( thrown );
+        assert( flaky.next() == 100 );
+        assert( flaky.next() == 101 );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
+
+int test_MySQLXAsyncRepository() {
+    puts("=== test_MySQLXAsyncRepository");
+    try {
+        using Row = MemoryRepository::Row;
+        MemoryRepository memory;
+        std::vector<std::size_t> ids;
+        {
+            ormx::MySQLXAsyncRepository<Repository<Row, std::size_t>> async(&memory, 4);
+            std::vector<std::future<std::optional<Row>>> inserted;
+            for(int i = 0; i < 10; i++) {
+                inserted.push_back(async.insert(Row(0, "row_" + std::to_string(i))));     // 結果を待たずに積む
+            }
+            std::future<std::vector<std::size_t>> many = async.insertMany(std::vector<Row>{Row(0, "many_1"), Row(0, "many_2")});
+            std::future<std::optional<Row>> found = async.findOne(std::size_t(3));     // 積んだ順に実行されるので、3 番目の insert は完了している
+            std::future<void> removed = async.remove(std::size_t(1));
+            std::future<std::optional<Row>> bad = async.submit([](const Repository<Row, std::size_t>&) -> std::optional<Row> {
+                throw std::runtime_error("It's async error test.");
+            });
+            async.flush();
+            assert( async.pendingCount() == 0 );
+            for(std::size_t i = 0; i < inserted.size(); i++) {
+                assert( inserted[i].get().value().first == i + 1 );
+            }
+            ids = many.get();
+            assert( found.get().value().second == "row_2" );
+            removed.get();
+            bool thrown = false;
+            try {
+                bad.get();
+            } catch(std::exception& e) {
+                ptr_print_error<const decltype(e)&>(e);
+                thrown = true;
+            }
+            assert( thrown );
+            // 失敗した文の後も続けて使える
+            std::future<FindResult<Row, std::size_t>> result = async.findByIds(std::vector<std::size_t>{1, ids[0], ids[1]});
+            FindResult<Row, std::size_t> rows = result.get();
+            assert( rows.missing.size() == 1 && rows.missing[0] == 1 );
+            async.update(Row(2, "row_1_updated"));
+        }   // デストラクタは残りを実行してから終了する
+        ptr_lambda_debug<const char*, const std::size_t&>("many ids size is ", ids.size());
+        assert( memory.findOne(2).value().second == "row_1_updated" );
+        return EXIT_SUCCESS;
+    } catch(std::exception& e) {
+        ptr_print_error<const decltype(e)&>(e);
+        return EXIT_FAILURE;
+    }
+}
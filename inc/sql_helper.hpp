@@ -2,6 +2,9 @@
 #define SQL_HELPER_H_
 
 #include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstddef>
 
 /**
  * SQLヘルパーモジュール。
@@ -10,15 +13,85 @@
  * カラム名を強制的に囲むように修正したため、安全性が向上している。
  * ただし、カラム名のユーザ入力は依然として受け付けてはならない。
  * その場合は結局SQLインジェクションの危険が残る。 
+ *
+ * テーブル名、カラム名がリテラルで決まっている場合は、テンプレート引数に文字列を渡す
+ * constexpr 版（例 insert_sql<"contractor", "id", "email">()）を使うこと。
+ * 同じ SQL をコンパイル時に静的な定数として生成するので、実行時の文字列の組み立て（メモリ確保）は発生しない。
  */
 
+namespace tmp::helper {
+/**
+ * fixed_string 構造体
+ *
+ * 文字列リテラルをテンプレート引数（NTTP）として受け取るためのもの。
+ * N は終端の '\0' を含む。
+*/
+template <std::size_t N>
+struct fixed_string {
+    char data[N]{};
+    constexpr fixed_string() = default;
+    constexpr fixed_string(const char (&s)[N]) {
+        std::copy_n(s, N, data);
+    }
+    constexpr std::size_t size() const {
+        return N - 1;
+    }
+    constexpr std::string_view view() const {
+        return std::string_view(data, N - 1);
+    }
+};
+
+namespace detail {
+// 1 周目は長さだけを数え、2 周目で確保済みの fixed_string に書き込む。
+struct counter {
+    std::size_t n = 0;
+    constexpr counter& append(std::string_view s) {
+        n += s.size();
+        return *this;
+    }
+    constexpr counter& number(std::size_t v) {
+        do { n++; v /= 10; } while(v);
+        return *this;
+    }
+};
+struct writer {
+    char* p;
+    constexpr writer& append(std::string_view s) {
+        for(char c: s) {
+            *p++ = c;
+        }
+        return *this;
+    }
+    constexpr writer& number(std::size_t v) {
+        char buf[20]{};
+        std::size_t len = 0;
+        do { buf[len++] = static_cast<char>('0' + v % 10); v /= 10; } while(v);
+        while(len) {
+            *p++ = buf[--len];
+        }
+        return *this;
+    }
+};
+template <class Gen>
+constexpr auto build() {
+    constexpr std::size_t n = [] { counter c; Gen::write(c); return c.n; }();
+    fixed_string<n + 1> out{};
+    writer w{out.data};
+    Gen::write(w);
+    return out;
+}
+// Gen ごとに 1 つだけ生成される静的な SQL
+template <class Gen>
+inline constexpr auto sql_v = build<Gen>();
+}   // namespace detail
+}   // namespace tmp::helper
+
 namespace tmp::postgres::helper {
 template <class... Args>
 std::string insert_sql(const std::string& table, Args&&... fields)
 {
     // R"(INSERT INTO contractor (id, company_id, email, password, name, roles) VALUES ($1, $2, $3, $4, $5, $6))"
     size_t size = sizeof...(fields);
-    printf("size: %zu\n", size);
     std::string sql = "INSERT INTO " + table + '\n';
     const std::string dollar = "$";
     std::string flds;
@@ -119,6 +192,96 @@ std::string delete_by_pkey_sql(const std::string& table, const std::string& pkey
     return sql;
 }
 
+/**
+ * 以下 constexpr 版、実行時版と同じ SQL を返す。
+*/
+
+namespace detail {
+using tmp::helper::fixed_string;
+
+template <fixed_string Table, fixed_string... Fields>
+struct insert_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        constexpr std::size_t size = sizeof...(Fields);
+        s.append("INSERT INTO ").append(Table.view()).append("\n( ");
+        std::size_t i = 0;
+        ((s.append("\"").append(Fields.view()).append(++i < size ? "\", " : "\"")), ...);
+        s.append(" )\nVALUES\n( ");
+        for(std::size_t j = 1; j <= size; j++) {
+            s.append("$").number(j).append(j < size ? ", " : "");
+        }
+        s.append(" )\n");
+    }
+};
+template <fixed_string Table, fixed_string... Fields>
+struct update_by_pkey_gen {
+    static_assert(sizeof...(Fields) >= 2, "the first field is the primary key, at least one more field is required.");
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        constexpr std::size_t size = sizeof...(Fields);
+        constexpr std::string_view names[] = {Fields.view()...};
+        s.append("UPDATE ").append(Table.view()).append("\nSET ");
+        for(std::size_t j = 1; j <= size; j++) {
+            s.append("\"").append(names[j - 1]).append("\"=$").number(j).append(j < size ? ", " : "");
+        }
+        s.append("\nWHERE \"").append(names[0]).append("\"=$1\n");
+    }
+};
+template <fixed_string Table, fixed_string Pkey, fixed_string... Fields>
+struct select_by_pkey_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        constexpr std::size_t size = sizeof...(Fields);
+        if constexpr (size == 0) {
+            s.append("SELECT * FROM ").append(Table.view()).append("\n");
+        } else {
+            s.append("SELECT ");
+            std::size_t i = 0;
+            ((s.append("\"").append(Fields.view()).append(++i < size ? "\", " : "\"")), ...);
+            s.append(" FROM ").append(Table.view()).append("\n");
+        }
+        s.append("WHERE \"").append(Pkey.view()).append("\"=$1");
+    }
+};
+template <fixed_string Table, fixed_string Pkey>
+struct delete_by_pkey_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        s.append("DELETE FROM ").append(Table.view()).append("\nWHERE \"").append(Pkey.view()).append("\"=$1");
+    }
+};
+}   // namespace detail
+
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string... Fields>
+constexpr std::string_view insert_sql() {
+    return tmp::helper::detail::sql_v<detail::insert_gen<Table, Fields...>>.view();
+}
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string... Fields>
+constexpr std::string_view update_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::update_by_pkey_gen<Table, Fields...>>.view();
+}
+// Fields を省略した場合は SELECT * となる
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string Pkey, tmp::helper::fixed_string... Fields>
+constexpr std::string_view select_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::select_by_pkey_gen<Table, Pkey, Fields...>>.view();
+}
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string Pkey>
+constexpr std::string_view delete_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::delete_by_pkey_gen<Table, Pkey>>.view();
+}
+
+/**
+ * constexpr 版が実行時版と同じ SQL を返すことの確認（実行時版の出力をそのまま書き写したもの）。
+ * どちらかの書式を変えた場合は、ここも合わせて変えること。
+*/
+static_assert(insert_sql<"contractor", "id">() == "INSERT INTO contractor\n( \"id\" )\nVALUES\n( $1 )\n");
+static_assert(insert_sql<"contractor", "id", "email">() == "INSERT INTO contractor\n( \"id\", \"email\" )\nVALUES\n( $1, $2 )\n");
+static_assert(update_by_pkey_sql<"contractor", "id", "email">() == "UPDATE contractor\nSET \"id\"=$1, \"email\"=$2\nWHERE \"id\"=$1\n");
+static_assert(select_by_pkey_sql<"contractor", "id", "email", "name">() == "SELECT \"email\", \"name\" FROM contractor\nWHERE \"id\"=$1");
+static_assert(select_by_pkey_sql<"contractor", "id">() == "SELECT * FROM contractor\nWHERE \"id\"=$1");
+static_assert(delete_by_pkey_sql<"contractor", "id">() == "DELETE FROM contractor\nWHERE \"id\"=$1");
+
 }   // namespace tmp::postgres::helper
 
 namespace tmp::mysql::helper {
@@ -127,7 +290,6 @@ std::string insert_sql(const std::string& table, Args&&... fields)
 {
     // R"(INSERT INTO contractor (company_id, email, password, name, roles) VALUES (?, ?, ?, ?, ?))"
     size_t size = sizeof...(fields);
-    printf("size: %zu\n", size);
     std::string sql = "INSERT INTO " + table + '\n';
     std::string flds;
     std::string values;
@@ -201,6 +363,81 @@ std::string delete_by_pkey_sql(const std::string& table, const std::string& pkey
     return sql;
 }
 
+/**
+ * 以下 constexpr 版、実行時版と同じ SQL を返す。
+*/
+
+namespace detail {
+using tmp::helper::fixed_string;
+
+template <fixed_string Table, fixed_string... Fields>
+struct insert_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        constexpr std::size_t size = sizeof...(Fields);
+        s.append("INSERT INTO ").append(Table.view()).append("\n( ");
+        std::size_t i = 0;
+        ((s.append("`").append(Fields.view()).append(++i < size ? "`, " : "`")), ...);
+        s.append(" )\nVALUES\n( ");
+        for(std::size_t j = 1; j <= size; j++) {
+            s.append(j < size ? "?, " : "?");
+        }
+        s.append(" )\n");
+    }
+};
+template <fixed_string Table, fixed_string Pkey, fixed_string... Fields>
+struct update_by_pkey_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        constexpr std::size_t size = sizeof...(Fields);
+        s.append("UPDATE ").append(Table.view()).append("\nSET ");
+        std::size_t i = 0;
+        ((s.append("`").append(Fields.view()).append(++i < size ? "`=?, " : "`=?")), ...);
+        s.append("\nWHERE `").append(Pkey.view()).append("`=?\n");
+    }
+};
+template <fixed_string Table, fixed_string Pkey>
+struct select_by_pkey_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        s.append("SELECT * FROM ").append(Table.view()).append("\nWHERE `").append(Pkey.view()).append("`=?\n");
+    }
+};
+template <fixed_string Table, fixed_string Pkey>
+struct delete_by_pkey_gen {
+    template <class Sink>
+    static constexpr void write(Sink& s) {
+        s.append("DELETE FROM ").append(Table.view()).append("\nWHERE `").append(Pkey.view()).append("`=?\n");
+    }
+};
+}   // namespace detail
+
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string... Fields>
+constexpr std::string_view insert_sql() {
+    return tmp::helper::detail::sql_v<detail::insert_gen<Table, Fields...>>.view();
+}
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string Pkey, tmp::helper::fixed_string... Fields>
+constexpr std::string_view update_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::update_by_pkey_gen<Table, Pkey, Fields...>>.view();
+}
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string Pkey>
+constexpr std::string_view select_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::select_by_pkey_gen<Table, Pkey>>.view();
+}
+template <tmp::helper::fixed_string Table, tmp::helper::fixed_string Pkey>
+constexpr std::string_view delete_by_pkey_sql() {
+    return tmp::helper::detail::sql_v<detail::delete_by_pkey_gen<Table, Pkey>>.view();
+}
+
+/**
+ * constexpr 版が実行時版と同じ SQL を返すことの確認（postgres 版と同じく、実行時版の出力を書き写したもの）。
+*/
+static_assert(insert_sql<"contractor", "email">() == "INSERT INTO contractor\n( `email` )\nVALUES\n( ? )\n");
+static_assert(insert_sql<"contractor", "company_id", "email">() == "INSERT INTO contractor\n( `company_id`, `email` )\nVALUES\n( ?, ? )\n");
+static_assert(update_by_pkey_sql<"contractor", "id", "company_id", "email">() == "UPDATE contractor\nSET `company_id`=?, `email`=?\nWHERE `id`=?\n");
+static_assert(select_by_pkey_sql<"contractor", "id">() == "SELECT * FROM contractor\nWHERE `id`=?\n");
+static_assert(delete_by_pkey_sql<"contractor", "id">() == "DELETE FROM contractor\nWHERE `id`=?\n");
+
 }   // namespace tmp::mysql::helper
 
 #endif